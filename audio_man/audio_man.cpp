@@ -31,6 +31,7 @@ For more information, please refer to <https://unlicense.org>
 #include "audio_man.hpp"
 #include "private/playback/playback.hpp"
 #include "private/recording/recording.hpp"
+#include "private/recording/recording_archive/recording_archive.hpp"
 
 
 AudioMan::AudioMan()
@@ -102,6 +103,193 @@ void AudioRequest::Cancel() const
     }
 }
 
+bool AudioRequest::Start(uint64_t engine_time_frames) const
+{
+    if (!IsValid()) {
+        return false;
+    }
+
+    auto is_still_pending = future_result.wait_for(std::chrono::seconds(0)) == std::future_status::timeout;
+    return is_still_pending && impl->Start(engine_time_frames);
+}
+
+
+
+AudioStream::AudioStream(std::shared_ptr<PlaybackStream> ptr)
+{
+    impl = std::move(ptr);
+}
+
+bool AudioStream::IsValid() const
+{
+    return impl && impl->IsOpen();
+}
+
+size_t AudioStream::Write(const char *pcm_data, size_t count) const
+{
+    return impl ? impl->Write(pcm_data, count) : 0;
+}
+
+size_t AudioStream::Write(const std::vector<char> &pcm_data) const
+{
+    return Write(pcm_data.data(), pcm_data.size());
+}
+
+size_t AudioStream::SizeQueued() const
+{
+    return impl ? impl->SizeQueued() : 0;
+}
+
+uint64_t AudioStream::GetUnderrunsCount() const
+{
+    return impl ? impl->UnderrunsCount() : 0;
+}
+
+void AudioStream::Close() const
+{
+    if (impl) {
+        impl->Close();
+    }
+}
+
+
+RecordingArchiveWriter::RecordingArchiveWriter()
+{
+    impl = new RecordingArchiveWriterImpl{};
+}
+
+RecordingArchiveWriter::RecordingArchiveWriter(RecordingArchiveWriter &&other)
+{
+    std::swap(impl, other.impl);
+}
+
+RecordingArchiveWriter::~RecordingArchiveWriter()
+{
+    if (impl) {
+        delete impl;
+        impl = nullptr;
+    }
+}
+
+RecordingArchiveWriter& RecordingArchiveWriter::operator=(RecordingArchiveWriter &&other)
+{
+    if (&other != this) {
+        std::destroy_at(this);
+        std::construct_at(this, std::move(other));
+    }
+    return *this;
+}
+
+bool RecordingArchiveWriter::Open(const char *path) const
+{
+    return impl->Open(path);
+}
+
+bool RecordingArchiveWriter::Append(const std::vector<char> &chunks) const
+{
+    return impl->Append(chunks.data(), chunks.size());
+}
+
+bool RecordingArchiveWriter::Append(const char *chunks, size_t count) const
+{
+    return impl->Append(chunks, count);
+}
+
+bool RecordingArchiveWriter::Close() const
+{
+    return impl->Close();
+}
+
+bool RecordingArchiveWriter::IsOpen() const
+{
+    return impl->IsOpen();
+}
+
+
+RecordingArchiveReader::RecordingArchiveReader()
+{
+    impl = new RecordingArchiveReaderImpl{};
+}
+
+RecordingArchiveReader::RecordingArchiveReader(RecordingArchiveReader &&other)
+{
+    std::swap(impl, other.impl);
+}
+
+RecordingArchiveReader::~RecordingArchiveReader()
+{
+    if (impl) {
+        delete impl;
+        impl = nullptr;
+    }
+}
+
+RecordingArchiveReader& RecordingArchiveReader::operator=(RecordingArchiveReader &&other)
+{
+    if (&other != this) {
+        std::destroy_at(this);
+        std::construct_at(this, std::move(other));
+    }
+    return *this;
+}
+
+bool RecordingArchiveReader::Open(const char *path) const
+{
+    return impl->Open(path);
+}
+
+void RecordingArchiveReader::Close() const
+{
+    impl->Close();
+}
+
+bool RecordingArchiveReader::IsOpen() const
+{
+    return impl->IsOpen();
+}
+
+RecordingFormat_t RecordingArchiveReader::GetFormat() const
+{
+    return impl->GetFormat();
+}
+
+uint32_t RecordingArchiveReader::GetSampleRate() const
+{
+    return impl->GetSampleRate();
+}
+
+uint16_t RecordingArchiveReader::GetChannelsCount() const
+{
+    return impl->GetChannelsCount();
+}
+
+uint64_t RecordingArchiveReader::GetBeginFrame() const
+{
+    return impl->GetBeginFrame();
+}
+
+uint64_t RecordingArchiveReader::GetEndFrame() const
+{
+    return impl->GetEndFrame();
+}
+
+size_t RecordingArchiveReader::GetRangeDecodedSize(uint64_t t0, uint64_t t1) const
+{
+    return impl->GetRangeDecodedSize(t0, t1);
+}
+
+size_t RecordingArchiveReader::DecodeRange(uint64_t t0, uint64_t t1, std::span<char> out) const
+{
+    return impl->DecodeRange(t0, t1, out);
+}
+
+std::vector<char> RecordingArchiveReader::DecodeRange(uint64_t t0, uint64_t t1) const
+{
+    std::vector<char> data(impl->GetRangeDecodedSize(t0, t1));
+    data.resize(impl->DecodeRange(t0, t1, data));
+    return data;
+}
+
 
 
 bool AudioMan::InitPlayback() const
@@ -124,6 +312,81 @@ AudioRequest AudioMan::SubmitAudio(const char *audio_data, size_t count) const
     return impl_playback->SubmitAudio(audio_data, count);
 }
 
+AudioRequest AudioMan::SubmitAudio(std::vector<char> &&audio_data) const
+{
+    return impl_playback->SubmitAudio(std::make_shared<const std::vector<char>>(std::move(audio_data)));
+}
+
+AudioRequest AudioMan::SubmitAudio(std::shared_ptr<const std::vector<char>> audio_data) const
+{
+    return impl_playback->SubmitAudio(std::move(audio_data));
+}
+
+AudioRequest AudioMan::SubmitPcm(const char *pcm_data, size_t frames_count, RecordingFormat_t format, unsigned char channels, unsigned int sample_rate) const
+{
+    return impl_playback->SubmitPcm(pcm_data, frames_count, format, channels, sample_rate);
+}
+
+AudioRequest AudioMan::PrepareAudio(const std::vector<char> &audio_data) const
+{
+    return impl_playback->PrepareAudio(audio_data.data(), audio_data.size());
+}
+
+AudioRequest AudioMan::PrepareAudio(const char *audio_data, size_t count) const
+{
+    return impl_playback->PrepareAudio(audio_data, count);
+}
+
+AudioRequest AudioMan::PrepareAudio(std::vector<char> &&audio_data) const
+{
+    return impl_playback->PrepareAudio(std::make_shared<const std::vector<char>>(std::move(audio_data)));
+}
+
+AudioRequest AudioMan::PrepareAudio(std::shared_ptr<const std::vector<char>> audio_data) const
+{
+    return impl_playback->PrepareAudio(std::move(audio_data));
+}
+
+AudioRequest AudioMan::PreparePcm(const char *pcm_data, size_t frames_count, RecordingFormat_t format, unsigned char channels, unsigned int sample_rate) const
+{
+    return impl_playback->PreparePcm(pcm_data, frames_count, format, channels, sample_rate);
+}
+
+uint64_t AudioMan::GetPlaybackTimeFrames() const
+{
+    return impl_playback->GetTimeFrames();
+}
+
+unsigned int AudioMan::GetPlaybackSampleRate() const
+{
+    return impl_playback->GetSampleRate();
+}
+
+AudioStream AudioMan::OpenPlaybackStream(RecordingFormat_t format, unsigned char channels, unsigned int sample_rate, unsigned int buffer_ms) const
+{
+    return impl_playback->OpenStream(format, channels, sample_rate, buffer_ms);
+}
+
+void AudioMan::SetPlaybackCacheBudget(size_t max_bytes) const
+{
+    impl_playback->SetCacheBudget(max_bytes);
+}
+
+size_t AudioMan::GetPlaybackCacheBudget() const
+{
+    return impl_playback->GetCacheBudget();
+}
+
+PlaybackCacheStats_t AudioMan::GetPlaybackCacheStats() const
+{
+    return impl_playback->GetCacheStats();
+}
+
+void AudioMan::ClearPlaybackCache() const
+{
+    impl_playback->ClearCache();
+}
+
 void AudioMan::SetPlaybackVolumePercent(float sound_volume_percent) const
 {
     impl_playback->SetPlaybackVolumePercent(sound_volume_percent);
@@ -171,6 +434,26 @@ RecordingFormat_t AudioMan::GetRecordingRecordingFormat() const
     return impl_recording->GetRecordingRecordingFormat();
 }
 
+void AudioMan::SetRecordingCodec(RecordingCodec_t codec) const
+{
+    impl_recording->SetRecordingCodec(codec);
+}
+
+RecordingCodec_t AudioMan::GetRecordingCodec() const
+{
+    return impl_recording->GetRecordingCodec();
+}
+
+void AudioMan::SetRecordingFilter(RecordingFilter_t filter) const
+{
+    impl_recording->SetRecordingFilter(filter);
+}
+
+RecordingFilter_t AudioMan::GetRecordingFilter() const
+{
+    return impl_recording->GetRecordingFilter();
+}
+
 void AudioMan::SetRecordingSoundThresholdPercent(float sound_threshold_percent) const
 {
     impl_recording->SetRecordingSoundThresholdPercent(sound_threshold_percent);
@@ -191,6 +474,36 @@ float AudioMan::GetRecordingSoundGainPercent() const
     return impl_recording->GetRecordingSoundGainPercent();
 }
 
+void AudioMan::SetRecordingMemoryBudget(size_t max_bytes) const
+{
+    impl_recording->SetRecordingMemoryBudget(max_bytes);
+}
+
+size_t AudioMan::GetRecordingMemoryBudget() const
+{
+    return impl_recording->GetRecordingMemoryBudget();
+}
+
+void AudioMan::SetRecordingOverflowPolicy(RecordingOverflowPolicy_t policy) const
+{
+    impl_recording->SetRecordingOverflowPolicy(policy);
+}
+
+RecordingOverflowPolicy_t AudioMan::GetRecordingOverflowPolicy() const
+{
+    return impl_recording->GetRecordingOverflowPolicy();
+}
+
+void AudioMan::SetRecordingSpillFilePath(const char *path) const
+{
+    impl_recording->SetRecordingSpillFilePath(path);
+}
+
+RecordingOverflowStats_t AudioMan::GetRecordingOverflowStats() const
+{
+    return impl_recording->GetRecordingOverflowStats();
+}
+
 void AudioMan::ClearRecording() const
 {
     impl_recording->ClearRecording();
@@ -201,11 +514,76 @@ size_t AudioMan::SizeUnreadRecording() const
     return impl_recording->SizeUnreadRecording();
 }
 
+RecordingBufferStats_t AudioMan::GetRecordingBufferStats() const
+{
+    return impl_recording->GetRecordingBufferStats();
+}
+
+bool AudioMan::WaitForRecording(size_t min_bytes, std::chrono::milliseconds timeout) const
+{
+    return impl_recording->WaitForRecording(min_bytes, timeout);
+}
+
+int AudioMan::GetRecordingEventFd(size_t min_bytes) const
+{
+    return impl_recording->GetRecordingEventFd(min_bytes);
+}
+
+void AudioMan::SetRecordingCallback(RecordingCallback_t callback, size_t min_bytes, uint32_t min_ms) const
+{
+    impl_recording->SetRecordingCallback(std::move(callback), min_bytes, min_ms);
+}
+
+size_t AudioMan::GetRecordingDroppedChunksCount() const
+{
+    return impl_recording->GetRecordingDroppedChunksCount();
+}
+
+size_t AudioMan::GetRecordingRealtimeAllocationsCount() const
+{
+    return impl_recording->GetRecordingRealtimeAllocationsCount();
+}
+
 std::vector<char> AudioMan::GetUnreadRecording(size_t max_bytes) const
 {
     return impl_recording->GetUnreadRecording(max_bytes);
 }
 
+RecordingView_t AudioMan::ViewUnreadRecording(size_t max_bytes) const
+{
+    return impl_recording->ViewUnreadRecording(max_bytes);
+}
+
+size_t AudioMan::CommitUnreadRecordingView(size_t consumed_bytes) const
+{
+    return impl_recording->CommitUnreadRecordingView(consumed_bytes);
+}
+
+std::vector<RecordingChunkInfo_t> AudioMan::GetRecordingChunksInfo(const std::vector<char> &chunks) const
+{
+    return impl_recording->GetRecordingChunksInfo(chunks.data(), chunks.size());
+}
+
+std::vector<RecordingChunkInfo_t> AudioMan::GetRecordingChunksInfo(const char *chunks, size_t count) const
+{
+    return impl_recording->GetRecordingChunksInfo(chunks, count);
+}
+
+size_t AudioMan::GetRecordingChunksDecodedSize(const std::vector<char> &chunks) const
+{
+    return impl_recording->GetRecordingChunksDecodedSize(chunks.data(), chunks.size());
+}
+
+size_t AudioMan::GetRecordingChunksDecodedSize(const char *chunks, size_t count) const
+{
+    return impl_recording->GetRecordingChunksDecodedSize(chunks, count);
+}
+
+size_t AudioMan::DecodeRecordingChunks(const char *chunks, size_t count, std::span<char> out) const
+{
+    return impl_recording->DecodeRecordingChunks(chunks, count, out);
+}
+
 std::vector<char> AudioMan::DecodeRecordingChunks(const std::vector<char> &chunks) const
 {
     return impl_recording->DecodeRecordingChunks(chunks.data(), chunks.size());
@@ -215,3 +593,13 @@ std::vector<char> AudioMan::DecodeRecordingChunks(const char *chunks, size_t cou
 {
     return impl_recording->DecodeRecordingChunks(chunks, count);
 }
+
+size_t AudioMan::DecodeRecordingChunksParallel(const char *chunks, size_t count, std::span<char> out, unsigned int max_threads) const
+{
+    return impl_recording->DecodeRecordingChunksParallel(chunks, count, out, max_threads);
+}
+
+std::vector<char> AudioMan::DecodeRecordingChunksParallel(const std::vector<char> &chunks, unsigned int max_threads) const
+{
+    return impl_recording->DecodeRecordingChunksParallel(chunks.data(), chunks.size(), max_threads);
+}
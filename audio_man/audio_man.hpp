@@ -28,7 +28,12 @@ For more information, please refer to <https://unlicense.org>
 #pragma once
 
 #include <vector>
+#include <span>
 #include <future>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <cstdint> // uintxx_t
 
 
 class AudioRequestImpl;
@@ -46,6 +51,17 @@ public:
     std::shared_future<bool> FutureResult() const;
     bool Wait() const;
     void Cancel() const;
+    // plays a prepared request, at the given engine time (see AudioMan::GetPlaybackTimeFrames()) or now if 0
+    bool Start(uint64_t engine_time_frames = 0) const;
+};
+
+struct PlaybackCacheStats_t {
+    uint64_t hits{};
+    uint64_t misses{};
+    uint64_t evictions{};
+    uint64_t uncacheable{}; // played without the cache, too large for the budget or not decodable
+    size_t cached_clips{};
+    size_t cached_bytes{}; // decoded pcm
 };
 
 
@@ -57,6 +73,154 @@ enum class RecordingFormat_t : uint32_t {
     Unsigned8 = 8,
 };
 
+// persistent playback voice fed with raw pcm, closed by Close() or once the last copy is gone
+class PlaybackStream;
+class AudioStream {
+private:
+    std::shared_ptr<PlaybackStream> impl{};
+
+public:
+    AudioStream(std::shared_ptr<PlaybackStream> ptr);
+
+    bool IsValid() const;
+    // one writer at a time, queues as many whole frames as fit in the buffer and returns their size in bytes
+    size_t Write(const char *pcm_data, size_t count) const;
+    size_t Write(const std::vector<char> &pcm_data) const;
+    size_t SizeQueued() const; // bytes written but not played yet
+    // how many times the voice ran out of pcm while playing and fell back to silence
+    uint64_t GetUnderrunsCount() const;
+    void Close() const;
+};
+
+
+// how captured chunks are stored, compression always happens off the audio thread
+enum class RecordingCodec_t : uint32_t {
+    None, // raw pcm
+    Deflate,
+    Lossless, // linear prediction + rice coded residuals, integer formats only (Float32 falls back to Deflate)
+};
+
+// reversible transform applied to integer pcm before Deflate, ignored by the other codecs
+enum class RecordingFilter_t : uint32_t {
+    None,
+    DeltaBytePlanes, // per channel sample deltas split into byte planes
+};
+
+// what happens to compressed chunks once the unread ones exceed the recording memory budget
+enum class RecordingOverflowPolicy_t : uint32_t {
+    Spill, // the oldest chunks move to a memory mapped temporary file, GetUnreadRecording() reads them back first
+    DropOldest,
+    DropNewest, // new chunks are refused until the reader catches up
+};
+
+// counters since the recording buffer was created, ClearRecording() doesn't reset them
+struct RecordingOverflowStats_t {
+    size_t spilled_chunks{}; // moved to the spill file
+    size_t spilled_unread_bytes{}; // still waiting in the spill file
+    size_t dropped_oldest_chunks{}; // including spills which failed because the file couldn't grow
+    size_t dropped_newest_chunks{};
+};
+
+
+// serialized chunks read in place from the recording buffer, the stream is 'first' followed by 'second'
+// a chunk may be split between both when the buffer wraps around
+struct RecordingView_t {
+    std::span<const char> first{};
+    std::span<const char> second{};
+
+    size_t Size() const { return first.size() + second.size(); }
+    bool Empty() const { return first.empty() && second.empty(); }
+};
+
+// receives serialized chunks in place, the view is only valid during the call
+using RecordingCallback_t = std::function<void(const RecordingView_t &chunks)>;
+
+// unread chunks waiting in the recording buffer, spilled ones included
+// maintained as chunks come and go, reading it doesn't walk the buffer nor wait for the compression worker
+struct RecordingBufferStats_t {
+    size_t unread_bytes{}; // serialized, what GetUnreadRecording() would return without a limit
+    size_t unread_original_bytes{}; // decoded pcm
+    size_t unread_chunks{};
+    uint64_t oldest_frame_timestamp{}; // see RecordingChunkInfo_t::frame_timestamp, 0 if there's nothing unread
+    uint64_t newest_frame_timestamp{};
+};
+
+// what a serialized recording chunk says about itself, read from its header without decoding anything
+struct RecordingChunkInfo_t {
+    size_t offset{}; // of the chunk in the serialized stream
+    uint32_t version{}; // 1 for legacy chunks, which only know their sizes and whether they're deflated
+    RecordingCodec_t codec{};
+    RecordingFormat_t format{};
+    uint32_t sample_rate{};
+    uint16_t channels{};
+    // increases by 1 for every stored chunk and for every period dropped because the capture ring was full
+    // a gap means chunks were cleared or lost, silent periods leave none
+    uint64_t seq{};
+    uint64_t frame_timestamp{}; // device frames captured before this chunk since the recording started, silence included
+    uint32_t original_bytes{};
+    uint32_t compressed_bytes{};
+};
+
+
+// append-only file of the serialized chunks of one recording (as returned by AudioMan::GetUnreadRecording()) with a time index
+// chunks must come in capture order with the same format, sample rate and channels, legacy chunks are rejected
+class RecordingArchiveWriterImpl;
+class RecordingArchiveWriter
+{
+private:
+    RecordingArchiveWriterImpl *impl{};
+
+public:
+    RecordingArchiveWriter();
+    RecordingArchiveWriter(RecordingArchiveWriter &&other);
+    RecordingArchiveWriter(const RecordingArchiveWriter &other) = delete;
+    ~RecordingArchiveWriter(); // closes the archive
+
+    RecordingArchiveWriter& operator=(RecordingArchiveWriter &&other);
+    RecordingArchiveWriter& operator=(const RecordingArchiveWriter &other) = delete;
+
+    bool Open(const char *path) const; // creates or truncates the file
+    // either the whole stream is appended or nothing is
+    bool Append(const std::vector<char> &chunks) const;
+    bool Append(const char *chunks, size_t count) const;
+    bool Close() const; // writes the index
+    bool IsOpen() const;
+};
+
+// memory maps an archive and decodes time ranges without reading the whole file
+// time is measured in device frames, see RecordingChunkInfo_t::frame_timestamp
+class RecordingArchiveReaderImpl;
+class RecordingArchiveReader
+{
+private:
+    RecordingArchiveReaderImpl *impl{};
+
+public:
+    RecordingArchiveReader();
+    RecordingArchiveReader(RecordingArchiveReader &&other);
+    RecordingArchiveReader(const RecordingArchiveReader &other) = delete;
+    ~RecordingArchiveReader();
+
+    RecordingArchiveReader& operator=(RecordingArchiveReader &&other);
+    RecordingArchiveReader& operator=(const RecordingArchiveReader &other) = delete;
+
+    bool Open(const char *path) const; // archives which were never closed are indexed by scanning them
+    void Close() const;
+    bool IsOpen() const;
+
+    RecordingFormat_t GetFormat() const;
+    uint32_t GetSampleRate() const;
+    uint16_t GetChannelsCount() const;
+    uint64_t GetBeginFrame() const;
+    uint64_t GetEndFrame() const; // exclusive
+
+    // [t0, t1) is clamped to the stored chunks, silence which wasn't stored is filled back in
+    size_t GetRangeDecodedSize(uint64_t t0, uint64_t t1) const;
+    // 'out' must hold GetRangeDecodedSize() bytes, returns the bytes written or 0 on failure
+    size_t DecodeRange(uint64_t t0, uint64_t t1, std::span<char> out) const;
+    std::vector<char> DecodeRange(uint64_t t0, uint64_t t1) const;
+};
+
 
 class AudioPlayback;
 class AudioRecording;
@@ -81,6 +245,31 @@ public:
 
     AudioRequest SubmitAudio(const std::vector<char> &audio_data) const;
     AudioRequest SubmitAudio(const char *audio_data, size_t count) const;
+    // without copying, the buffer is taken over or shared by every request playing it
+    AudioRequest SubmitAudio(std::vector<char> &&audio_data) const;
+    AudioRequest SubmitAudio(std::shared_ptr<const std::vector<char>> audio_data) const;
+    // raw interleaved samples, no container probing or wav header needed
+    AudioRequest SubmitPcm(const char *pcm_data, size_t frames_count, RecordingFormat_t format, unsigned char channels, unsigned int sample_rate) const;
+
+    // the whole setup of the Submit*() ones ahead of time, the request only plays once started with AudioRequest::Start()
+    // until then it holds its sound and Wait() blocks, Cancel() releases it
+    AudioRequest PrepareAudio(const std::vector<char> &audio_data) const;
+    AudioRequest PrepareAudio(const char *audio_data, size_t count) const;
+    AudioRequest PrepareAudio(std::vector<char> &&audio_data) const;
+    AudioRequest PrepareAudio(std::shared_ptr<const std::vector<char>> audio_data) const;
+    AudioRequest PreparePcm(const char *pcm_data, size_t frames_count, RecordingFormat_t format, unsigned char channels, unsigned int sample_rate) const;
+    // engine clock for scheduled starts
+    uint64_t GetPlaybackTimeFrames() const;
+    unsigned int GetPlaybackSampleRate() const;
+    // for live or streamed pcm instead of submitting many small clips, 'buffer_ms' of audio can be queued ahead
+    AudioStream OpenPlaybackStream(RecordingFormat_t format, unsigned char channels, unsigned int sample_rate, unsigned int buffer_ms = 200) const;
+
+    // decoded pcm of submitted clips in the engine's format, replaying one skips the decoding
+    // least recently used clips are evicted past 'max_bytes', 0 = disabled (default)
+    void SetPlaybackCacheBudget(size_t max_bytes) const;
+    size_t GetPlaybackCacheBudget() const;
+    PlaybackCacheStats_t GetPlaybackCacheStats() const;
+    void ClearPlaybackCache() const;
 
     void SetPlaybackVolumePercent(float sound_volume_percent) const;
     float GetPlaybackVolumePercent() const;
@@ -99,17 +288,68 @@ public:
     unsigned char GetRecordingChannelsCount() const;
     RecordingFormat_t GetRecordingRecordingFormat() const;
 
+    void SetRecordingCodec(RecordingCodec_t codec) const; // applies to chunks which aren't compressed yet
+    RecordingCodec_t GetRecordingCodec() const;
+
+    void SetRecordingFilter(RecordingFilter_t filter) const; // applies to chunks which aren't compressed yet
+    RecordingFilter_t GetRecordingFilter() const;
+
     void SetRecordingSoundThresholdPercent(float sound_threshold_percent) const; // [0.0, 100.0]
     float GetRecordingSoundThresholdPercent() const;
 
     void SetRecordingSoundGainPercent(float sound_gain_percent) const; // [0.0, >= 100.0]
     float GetRecordingSoundGainPercent() const;
 
+    // serialized bytes of unread chunks kept in memory, 0 = unlimited (default)
+    void SetRecordingMemoryBudget(size_t max_bytes) const;
+    size_t GetRecordingMemoryBudget() const;
+    void SetRecordingOverflowPolicy(RecordingOverflowPolicy_t policy) const;
+    RecordingOverflowPolicy_t GetRecordingOverflowPolicy() const;
+    // where the next spill file is created, nullptr or empty = the temp directory
+    void SetRecordingSpillFilePath(const char *path) const;
+    RecordingOverflowStats_t GetRecordingOverflowStats() const;
+
     void ClearRecording() const;
     size_t SizeUnreadRecording() const;
+    RecordingBufferStats_t GetRecordingBufferStats() const; // consistent snapshot, safe from any thread
+    // blocks until at least 'min_bytes' (1 or more) are unread, the timeout expires or the recording is stopped
+    // returns whether 'min_bytes' are unread
+    bool WaitForRecording(size_t min_bytes, std::chrono::milliseconds timeout) const;
+    // descriptor for poll()/epoll() loops, readable while at least 'min_bytes' (1 or more) are unread
+    // every call returns the same one with a new threshold, it belongs to AudioMan: don't read it nor close it
+    // -1 on windows or if it couldn't be created
+    int GetRecordingEventFd(size_t min_bytes = 1) const;
+    // push instead of pull: 'callback' runs on a delivery thread of its own with every unread chunk in place
+    // once 'min_bytes' are unread or 'min_ms' of audio (0 = either one unused, both = as soon as anything comes)
+    // and with whatever is left once the recording stops; the chunks are consumed when it returns
+    // nullptr stops the deliveries, must not be called from the callback
+    void SetRecordingCallback(RecordingCallback_t callback, size_t min_bytes = 0, uint32_t min_ms = 0) const;
+    size_t GetRecordingDroppedChunksCount() const; // chunks lost because the reader was too slow
+    // heap allocations made in the capture callback, should stay at 0
+    // every one of them in builds with AUDIO_MAN_COUNT_RT_ALLOCATIONS, otherwise only the capture slots which had to grow
+    size_t GetRecordingRealtimeAllocationsCount() const;
     std::vector<char> GetUnreadRecording(size_t max_bytes = static_cast<size_t>(-1)) const;
+    // zero-copy GetUnreadRecording(), views up to 'max_bytes' of whole chunks where they are stored
+    // the view stays valid until it's committed, only one view at a time, reads return nothing meanwhile
+    // spilled chunks come first in views of their own, then the chunks kept in memory
+    // the overflow policy (except DropNewest) waits for the commit, the memory budget may be exceeded meanwhile
+    RecordingView_t ViewUnreadRecording(size_t max_bytes = static_cast<size_t>(-1)) const;
+    // consumes the whole chunks among the first 'consumed_bytes' of the view and releases it
+    // returns the bytes consumed, ClearRecording() while viewing leaves nothing to consume
+    size_t CommitUnreadRecordingView(size_t consumed_bytes = static_cast<size_t>(-1)) const;
+    std::vector<RecordingChunkInfo_t> GetRecordingChunksInfo(const std::vector<char> &chunks) const; // headers only, nothing is decoded
+    std::vector<RecordingChunkInfo_t> GetRecordingChunksInfo(const char *chunks, size_t count) const;
+    size_t GetRecordingChunksDecodedSize(const std::vector<char> &chunks) const; // read from the chunk headers, nothing is decoded
+    size_t GetRecordingChunksDecodedSize(const char *chunks, size_t count) const;
+    // decodes into 'out' without allocating the output, stops before the first chunk which doesn't fit
+    // returns the bytes written, 'out' should hold GetRecordingChunksDecodedSize() bytes
+    size_t DecodeRecordingChunks(const char *chunks, size_t count, std::span<char> out) const;
     std::vector<char> DecodeRecordingChunks(const std::vector<char> &chunks) const;
     std::vector<char> DecodeRecordingChunks(const char *chunks, size_t count) const;
+    // same output as DecodeRecordingChunks(), chunks are decoded concurrently on up to 'max_threads' threads (0 = all cores)
+    // worth it for large archives, small inputs are decoded on the calling thread only, helper threads are kept for later calls
+    size_t DecodeRecordingChunksParallel(const char *chunks, size_t count, std::span<char> out, unsigned int max_threads = 0) const;
+    std::vector<char> DecodeRecordingChunksParallel(const std::vector<char> &chunks, unsigned int max_threads = 0) const;
     // *** recording *** //
 
 };
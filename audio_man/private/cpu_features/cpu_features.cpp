@@ -0,0 +1,110 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#include "cpu_features.hpp"
+
+#if defined(AUDIO_MAN_X86)
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+
+
+#if defined(AUDIO_MAN_X86)
+
+// https://en.wikipedia.org/wiki/CPUID
+
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+    int int_regs[4]{};
+    __cpuidex(int_regs, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) {
+        regs[i] = static_cast<unsigned int>(int_regs[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static unsigned long long xgetbv0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int eax = 0, edx = 0;
+    __asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+static CpuFeatures_t detect_cpu_features()
+{
+    CpuFeatures_t features{};
+
+    unsigned int regs[4]{}; // eax, ebx, ecx, edx
+    cpuid(0, 0, regs);
+    const auto max_leaf = regs[0];
+    if (max_leaf < 1) {
+        return features;
+    }
+
+    cpuid(1, 0, regs);
+    features.sse2  = (regs[3] & (1u << 26)) != 0;
+    features.ssse3 = (regs[2] & (1u << 9)) != 0;
+    features.sse41 = (regs[2] & (1u << 19)) != 0;
+
+    // AVX registers are only usable if the OS saves them on context switches
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool avx = (regs[2] & (1u << 28)) != 0;
+    const bool os_saves_ymm = osxsave && avx && ((xgetbv0() & 0x6) == 0x6); // xmm + ymm state
+    if (os_saves_ymm && max_leaf >= 7) {
+        cpuid(7, 0, regs);
+        features.avx2 = (regs[1] & (1u << 5)) != 0;
+    }
+
+    return features;
+}
+
+#else
+
+static CpuFeatures_t detect_cpu_features()
+{
+    return {};
+}
+
+#endif
+
+
+const CpuFeatures_t& GetCpuFeatures()
+{
+    static const CpuFeatures_t features = detect_cpu_features();
+    return features;
+}
@@ -0,0 +1,59 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define AUDIO_MAN_X86
+#endif
+
+// lets a single function use instructions beyond the compiler's baseline
+// the caller must check GetCpuFeatures() before calling it
+// MSVC allows intrinsics of any instruction set without this
+#if defined(AUDIO_MAN_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define AUDIO_MAN_TARGET_SSE2  __attribute__((target("sse2")))
+    #define AUDIO_MAN_TARGET_SSSE3 __attribute__((target("ssse3")))
+    #define AUDIO_MAN_TARGET_SSE41 __attribute__((target("sse4.1")))
+    #define AUDIO_MAN_TARGET_AVX2  __attribute__((target("avx2")))
+#else
+    #define AUDIO_MAN_TARGET_SSE2
+    #define AUDIO_MAN_TARGET_SSSE3
+    #define AUDIO_MAN_TARGET_SSE41
+    #define AUDIO_MAN_TARGET_AVX2
+#endif
+
+
+struct CpuFeatures_t {
+    bool sse2 = false;
+    bool ssse3 = false;
+    bool sse41 = false;
+    bool avx2 = false; // also implies the OS saves the upper halves of the ymm registers
+};
+
+// detected once on first use
+const CpuFeatures_t& GetCpuFeatures();
@@ -0,0 +1,140 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #if defined(__linux__)
+        #include <sys/eventfd.h>
+    #endif
+#endif
+
+#include <cstdint> // uintxx_t
+
+#include "event_fd.hpp"
+
+
+EventFd::~EventFd()
+{
+    Close();
+}
+
+#if defined(_WIN32)
+
+bool EventFd::Open()
+{
+    return false;
+}
+
+void EventFd::Close()
+{
+}
+
+void EventFd::Set()
+{
+}
+
+void EventFd::Reset()
+{
+}
+
+#else
+
+bool EventFd::Open()
+{
+    Close();
+
+#if defined(__linux__)
+    read_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    write_fd = read_fd;
+    return read_fd >= 0;
+#else
+    int fds[2]{};
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    for (auto fd : fds) { // a full pipe must not block the writer, nor an empty one the reset
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+
+    read_fd = fds[0];
+    write_fd = fds[1];
+    return true;
+#endif
+}
+
+void EventFd::Close()
+{
+    if (write_fd >= 0 && write_fd != read_fd) {
+        close(write_fd);
+    }
+    if (read_fd >= 0) {
+        close(read_fd);
+    }
+
+    read_fd = -1;
+    write_fd = -1;
+    is_set = false;
+}
+
+void EventFd::Set()
+{
+    if (is_set || write_fd < 0) {
+        return;
+    }
+
+    // an eventfd takes exactly 8 bytes, a pipe is fine with them too
+    const uint64_t value = 1;
+    is_set = write(write_fd, &value, sizeof(value)) == static_cast<ssize_t>(sizeof(value));
+}
+
+void EventFd::Reset()
+{
+    if (!is_set) {
+        return;
+    }
+
+    // drained since it's non blocking
+    uint64_t value{};
+    while (read(read_fd, &value, sizeof(value)) > 0) {
+    }
+    is_set = false;
+}
+
+#endif
+
+bool EventFd::IsOpen() const
+{
+    return read_fd >= 0;
+}
+
+int EventFd::Fd() const
+{
+    return read_fd;
+}
@@ -0,0 +1,56 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#pragma once
+
+
+// file descriptor which can be waited on with poll()/epoll() along with sockets
+// eventfd on linux, the read end of a pipe on other posix systems, unsupported on windows
+// the owner sets and resets the readable state, whoever polls it must not read from it
+class EventFd
+{
+private:
+    int read_fd = -1;
+    int write_fd = -1; // same as 'read_fd' for an eventfd
+    bool is_set{};
+
+public:
+    EventFd() = default;
+    EventFd(const EventFd &other) = delete;
+    ~EventFd();
+
+    EventFd& operator=(const EventFd &other) = delete;
+
+    bool Open(); // not set
+    void Close();
+    bool IsOpen() const;
+
+    void Set(); // readable
+    void Reset(); // not readable anymore
+    int Fd() const; // -1 if not open
+};
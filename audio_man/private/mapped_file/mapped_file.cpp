@@ -0,0 +1,290 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#include "mapped_file.hpp"
+
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#if defined(_WIN32)
+
+static bool set_file_size(void *file_handle, size_t new_size)
+{
+    LARGE_INTEGER file_size{};
+    file_size.QuadPart = static_cast<LONGLONG>(new_size);
+    return SetFilePointerEx(file_handle, file_size, nullptr, FILE_BEGIN) && SetEndOfFile(file_handle);
+}
+
+bool MappedFile::map(size_t new_size)
+{
+    LARGE_INTEGER mapping_size{};
+    mapping_size.QuadPart = static_cast<LONGLONG>(new_size);
+    mapping_handle = CreateFileMappingA(file_handle, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, mapping_size.HighPart, mapping_size.LowPart, nullptr);
+    if (!mapping_handle) {
+        return false;
+    }
+
+    data = static_cast<char *>(MapViewOfFile(mapping_handle, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, new_size));
+    if (!data) {
+        CloseHandle(mapping_handle);
+        mapping_handle = nullptr;
+        return false;
+    }
+
+    size = new_size;
+    return true;
+}
+
+void MappedFile::unmap()
+{
+    if (data) {
+        UnmapViewOfFile(data);
+    }
+    if (mapping_handle) {
+        CloseHandle(mapping_handle);
+    }
+
+    data = nullptr;
+    size = 0;
+    mapping_handle = nullptr;
+}
+
+bool MappedFile::OpenRead(const char *path)
+{
+    Close();
+
+    file_handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        file_handle = nullptr;
+        return false;
+    }
+
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file_handle, &file_size) || !file_size.QuadPart || !map(static_cast<size_t>(file_size.QuadPart))) {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+bool MappedFile::CreateReadWrite(const char *path, size_t new_size, bool temporary)
+{
+    Close();
+
+    const DWORD flags = temporary ? FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE : FILE_ATTRIBUTE_NORMAL;
+    file_handle = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, temporary ? FILE_SHARE_DELETE : 0, nullptr, CREATE_ALWAYS, flags, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        file_handle = nullptr;
+        return false;
+    }
+
+    writable = true;
+    if (!map(new_size)) { // mapping a bigger size than the file grows it
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+bool MappedFile::Resize(size_t new_size)
+{
+    if (!writable || !file_handle) {
+        return false;
+    }
+
+    const auto old_size = size;
+    unmap();
+
+    // mapping alone could only grow the file
+    if (set_file_size(file_handle, new_size) && map(new_size)) {
+        return true;
+    }
+
+    // keep the previous content mapped
+    set_file_size(file_handle, old_size);
+    map(old_size);
+    return false;
+}
+
+void MappedFile::Close()
+{
+    unmap();
+    if (file_handle) {
+        CloseHandle(file_handle);
+    }
+
+    file_handle = nullptr;
+    writable = false;
+}
+
+#else
+
+// blocks are allocated up front where possible, writing to a sparse mapping on a full disk raises SIGBUS instead of failing
+static bool resize_file(int fd, size_t new_size)
+{
+    if (ftruncate(fd, static_cast<off_t>(new_size)) != 0) {
+        return false;
+    }
+#if defined(__linux__)
+    return posix_fallocate(fd, 0, static_cast<off_t>(new_size)) == 0;
+#else
+    return true;
+#endif
+}
+
+bool MappedFile::map(size_t new_size)
+{
+    auto mapping = mmap(nullptr, new_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    data = static_cast<char *>(mapping);
+    size = new_size;
+    return true;
+}
+
+void MappedFile::unmap()
+{
+    if (data) {
+        munmap(data, size);
+    }
+
+    data = nullptr;
+    size = 0;
+}
+
+bool MappedFile::OpenRead(const char *path)
+{
+    Close();
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0 || !map(static_cast<size_t>(file_stat.st_size))) {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+bool MappedFile::CreateReadWrite(const char *path, size_t new_size, bool temporary)
+{
+    Close();
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    if (temporary) { // the mapping keeps the data alive until it's closed
+        unlink(path);
+    }
+
+    writable = true;
+    if (!resize_file(fd, new_size) || !map(new_size)) {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+bool MappedFile::Resize(size_t new_size)
+{
+    if (!writable || fd < 0) {
+        return false;
+    }
+
+    const auto old_size = size;
+    unmap();
+    if (resize_file(fd, new_size) && map(new_size)) {
+        return true;
+    }
+
+    // keep the previous content mapped
+    resize_file(fd, old_size);
+    map(old_size);
+    return false;
+}
+
+void MappedFile::Close()
+{
+    unmap();
+    if (fd >= 0) {
+        close(fd);
+    }
+
+    fd = -1;
+    writable = false;
+}
+
+#endif
+
+bool MappedFile::IsOpen() const
+{
+    return data != nullptr;
+}
+
+const char* MappedFile::Data() const
+{
+    return data;
+}
+
+char* MappedFile::WritableData()
+{
+    return writable ? data : nullptr;
+}
+
+size_t MappedFile::Size() const
+{
+    return size;
+}
@@ -0,0 +1,72 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#pragma once
+
+#include <cstring> // size_t
+
+
+// whole file mapped into memory, mmap() on posix and a file mapping on windows
+class MappedFile
+{
+private:
+    char *data{};
+    size_t size{};
+#if defined(_WIN32)
+    void *file_handle{};
+    void *mapping_handle{};
+#else
+    int fd = -1;
+#endif
+    bool writable{};
+
+    bool map(size_t new_size);
+    void unmap();
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &other) = delete;
+    ~MappedFile();
+
+    MappedFile& operator=(const MappedFile &other) = delete;
+
+    // read only, fails for empty files
+    bool OpenRead(const char *path);
+    // creates or truncates 'path' to 'size' bytes and maps it read/write
+    // a temporary file is removed by the os once it's closed, even if the process dies
+    bool CreateReadWrite(const char *path, size_t size, bool temporary);
+    // read/write mappings only, the content is kept up to the smaller size and Data() may move
+    // on failure the previous size stays mapped if possible, check IsOpen()
+    bool Resize(size_t new_size);
+    void Close();
+
+    bool IsOpen() const;
+    const char* Data() const;
+    char* WritableData(); // nullptr unless mapped read/write
+    size_t Size() const;
+};
@@ -0,0 +1,200 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#include <algorithm>
+#include <bit> // std::rotl
+
+#include "clip_cache.hpp"
+
+
+
+// word at a time multiply/rotate mixing, fast enough to run on every submission
+static uint64_t mix_word(uint64_t hash, uint64_t word, uint64_t mul, uint64_t rot_mul, int rot)
+{
+    return std::rotl(hash ^ (word * mul), rot) * rot_mul;
+}
+
+static uint64_t avalanche(uint64_t hash, uint64_t mul)
+{
+    hash ^= hash >> 33;
+    hash *= mul;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+ClipKey_t ClipCache::Key(const char *data, size_t count)
+{
+    // the second lane uses its own constants and rotation, so it doesn't collide along with the first one
+    constexpr uint64_t k0 = 0x9E3779B97F4A7C15ull;
+    constexpr uint64_t k1 = 0xC2B2AE3D27D4EB4Full;
+    constexpr uint64_t k2 = 0x165667B19E3779F9ull;
+    constexpr uint64_t k3 = 0x85EBCA77C2B2AE63ull;
+
+    uint64_t hash = k0 ^ (count * k1);
+    uint64_t check = k2 ^ (count * k3);
+    size_t idx = 0;
+    for (; idx + 8 <= count; idx += 8) {
+        uint64_t word{};
+        std::memcpy(&word, data + idx, sizeof(word));
+        hash = mix_word(hash, word, k1, k0, 31);
+        check = mix_word(check, word, k3, k2, 27);
+    }
+
+    if (idx < count) {
+        uint64_t tail{};
+        std::memcpy(&tail, data + idx, count - idx);
+        hash = mix_word(hash, tail, k1, k0, 31);
+        check = mix_word(check, tail, k3, k2, 27);
+    }
+
+    return ClipKey_t{ avalanche(hash, k1), avalanche(check, k3), count };
+}
+
+std::list<ClipCache::Entry_t>::iterator ClipCache::find(const ClipKey_t &key)
+{
+    const auto [first, last] = index.equal_range(key.hash);
+    for (auto itr = first; itr != last; ++itr) {
+        if (itr->second->key == key) {
+            return itr->second;
+        }
+    }
+    return entries.end();
+}
+
+void ClipCache::evict_to(size_t max_bytes)
+{
+    while (cached_bytes > max_bytes && !entries.empty()) {
+        auto &oldest = entries.back();
+
+        const auto [first, last] = index.equal_range(oldest.key.hash);
+        for (auto itr = first; itr != last; ++itr) {
+            if (itr->second == --entries.end()) {
+                index.erase(itr);
+                break;
+            }
+        }
+
+        cached_bytes -= oldest.pcm->size();
+        entries.pop_back();
+        stats.evictions++;
+    }
+}
+
+void ClipCache::SetBudget(size_t max_bytes)
+{
+    std::lock_guard lock(mtx);
+
+    budget = max_bytes;
+    evict_to(budget);
+}
+
+size_t ClipCache::GetBudget() const
+{
+    std::lock_guard lock(mtx);
+    return budget;
+}
+
+bool ClipCache::IsEnabled() const
+{
+    return GetBudget() > 0;
+}
+
+std::shared_ptr<const std::vector<char>> ClipCache::Find(const ClipKey_t &key, bool &is_uncacheable)
+{
+    std::lock_guard lock(mtx);
+
+    is_uncacheable = false;
+    for (auto rejected_itr = rejected.begin(); rejected_itr != rejected.end(); ++rejected_itr) {
+        if (rejected_itr->key != key) {
+            continue;
+        }
+
+        if (rejected_itr->decoded_bytes > budget) {
+            rejected.splice(rejected.begin(), rejected, rejected_itr);
+            stats.uncacheable++;
+            is_uncacheable = true;
+            return {};
+        }
+        rejected.erase(rejected_itr); // the budget was raised since, worth another try
+        break;
+    }
+
+    const auto itr = find(key);
+    if (itr == entries.end()) {
+        stats.misses++;
+        return {};
+    }
+
+    entries.splice(entries.begin(), entries, itr);
+    stats.hits++;
+    return itr->pcm;
+}
+
+void ClipCache::Insert(const ClipKey_t &key, std::shared_ptr<const std::vector<char>> pcm)
+{
+    std::lock_guard lock(mtx);
+
+    if (!pcm || pcm->size() > budget || find(key) != entries.end()) {
+        return;
+    }
+
+    evict_to(budget - pcm->size());
+    cached_bytes += pcm->size();
+    entries.emplace_front(Entry_t{ key, std::move(pcm) });
+    index.emplace(key.hash, entries.begin());
+}
+
+void ClipCache::Reject(const ClipKey_t &key, size_t decoded_bytes)
+{
+    std::lock_guard lock(mtx);
+
+    rejected.emplace_front(Rejected_t{ key, decoded_bytes });
+    if (rejected.size() > max_rejected) {
+        rejected.pop_back();
+    }
+}
+
+void ClipCache::Clear()
+{
+    std::lock_guard lock(mtx);
+
+    index.clear();
+    entries.clear();
+    rejected.clear();
+    cached_bytes = 0;
+}
+
+PlaybackCacheStats_t ClipCache::GetStats() const
+{
+    std::lock_guard lock(mtx);
+
+    auto result = stats;
+    result.cached_clips = entries.size();
+    result.cached_bytes = cached_bytes;
+    return result;
+}
@@ -0,0 +1,98 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#pragma once
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <cstring> // size_t
+#include <cstdint> // uintxx_t
+
+#include "../../../audio_man.hpp"
+
+
+// identifies a clip by its encoded bytes, two independent hashes are computed in a single pass
+// both are non-cryptographic: accidental collisions on both at once are out of reach, crafted ones aren't,
+// so clips are expected to come from the application and not from untrusted sources
+struct ClipKey_t {
+    uint64_t hash{};
+    uint64_t check{}; // compared on every lookup along with 'hash' and 'encoded_size'
+    size_t encoded_size{};
+
+    bool operator==(const ClipKey_t &other) const = default;
+};
+
+// decoded pcm of recently played clips, keyed by the hashes and size of their encoded bytes
+// the least recently used clips are evicted once the budget is exceeded, requests still playing one keep it alive
+// clips which don't fit (or don't decode) are remembered so they are not decoded again on every submission
+class ClipCache
+{
+private:
+    struct Entry_t {
+        ClipKey_t key{};
+        std::shared_ptr<const std::vector<char>> pcm{};
+    };
+
+    struct Rejected_t {
+        ClipKey_t key{};
+        size_t decoded_bytes{}; // at least, -1 = not decodable
+    };
+
+    static constexpr size_t max_rejected = 256;
+
+    std::list<Entry_t> entries{}; // most recently used first
+    std::list<Rejected_t> rejected{}; // most recently seen first, capped at 'max_rejected'
+    std::unordered_multimap<uint64_t, std::list<Entry_t>::iterator> index{}; // by 'ClipKey_t::hash'
+    size_t budget{}; // 0 = disabled
+    size_t cached_bytes{};
+    PlaybackCacheStats_t stats{};
+    mutable std::mutex mtx{};
+
+    std::list<Entry_t>::iterator find(const ClipKey_t &key);
+    void evict_to(size_t max_bytes);
+
+public:
+    static ClipKey_t Key(const char *data, size_t count);
+
+    void SetBudget(size_t max_bytes);
+    size_t GetBudget() const;
+    bool IsEnabled() const;
+
+    // nullptr on a miss or for a clip known not to fit ('is_uncacheable'), counts a hit, a miss or an uncacheable one
+    std::shared_ptr<const std::vector<char>> Find(const ClipKey_t &key, bool &is_uncacheable);
+    // ignored when the clip alone exceeds the budget
+    void Insert(const ClipKey_t &key, std::shared_ptr<const std::vector<char>> pcm);
+    // remembers a clip which decodes to at least 'decoded_bytes' (-1 = not at all) until the budget is raised past it
+    void Reject(const ClipKey_t &key, size_t decoded_bytes);
+    void Clear();
+
+    PlaybackCacheStats_t GetStats() const;
+};
@@ -34,6 +34,72 @@ For more information, please refer to <https://unlicense.org>
 
 
 
+static ma_format to_ma_format(RecordingFormat_t format)
+{
+    switch (format) {
+    case RecordingFormat_t::Float32: return ma_format_f32;
+    case RecordingFormat_t::Signed16: return ma_format_s16;
+    case RecordingFormat_t::Signed24: return ma_format_s24;
+    case RecordingFormat_t::Signed32: return ma_format_s32;
+    case RecordingFormat_t::Unsigned8: return ma_format_u8;
+    
+    default: return ma_format_unknown;
+    }
+}
+
+
+
+// the whole clip as f32 pcm in the engine's layout, nothing if it can't be decoded or exceeds 'max_bytes'
+// 'decoded_bytes' is set to the decoded size, or what it's known to exceed, -1 if it can't be decoded
+static std::shared_ptr<const std::vector<char>> decode_clip(ma_engine *engine, const char *audio_data, size_t count, size_t max_bytes, size_t &decoded_bytes)
+{
+    decoded_bytes = static_cast<size_t>(-1);
+
+    constexpr ma_uint64 block_frames = 4096;
+
+    const auto channels = ma_engine_get_channels(engine);
+    const auto frame_bytes = ma_get_bytes_per_frame(ma_format_f32, channels);
+
+    auto cfg = ma_decoder_config_init(ma_format_f32, channels, ma_engine_get_sample_rate(engine));
+    ma_decoder decoder{};
+    if (ma_decoder_init_memory(audio_data, count, &cfg, &decoder) != MA_SUCCESS) {
+        return {};
+    }
+
+    std::vector<char> pcm{};
+    ma_uint64 length_frames = 0;
+    if (ma_decoder_get_length_in_pcm_frames(&decoder, &length_frames) == MA_SUCCESS && length_frames) {
+        if (length_frames * frame_bytes > max_bytes) { // known before decoding anything
+            decoded_bytes = length_frames * frame_bytes;
+            ma_decoder_uninit(&decoder);
+            return {};
+        }
+        pcm.reserve(length_frames * frame_bytes);
+    }
+
+    while (pcm.size() <= max_bytes) {
+        const auto old_size = pcm.size();
+        pcm.resize(old_size + block_frames * frame_bytes);
+
+        ma_uint64 frames_read = 0;
+        const auto res = ma_decoder_read_pcm_frames(&decoder, pcm.data() + old_size, block_frames, &frames_read);
+        pcm.resize(old_size + frames_read * frame_bytes);
+        if (res != MA_SUCCESS || frames_read < block_frames) {
+            break;
+        }
+    }
+    ma_decoder_uninit(&decoder);
+
+    if (pcm.empty()) {
+        return {};
+    }
+    decoded_bytes = pcm.size();
+    if (pcm.size() > max_bytes) {
+        return {};
+    }
+    return std::make_shared<const std::vector<char>>(std::move(pcm));
+}
+
 void AudioRequestImpl::remove_from_requests_manager()
 {
     requests_man->Remove(my_itr);
@@ -49,6 +115,7 @@ AudioRequestImpl::AudioRequestImpl(AudioRequestImpl &&other) noexcept
 {
     std::swap(decoder, other.decoder);
     std::swap(cfg, other.cfg);
+    std::swap(buffer_ref, other.buffer_ref);
 
     std::swap(sound, other.sound);
     
@@ -93,10 +160,42 @@ void AudioRequestImpl::Cancel(bool success)
         ma_decoder_uninit(&decoder.value());
     }
 
+    if (buffer_ref) {
+        ma_audio_buffer_ref_uninit(&buffer_ref.value());
+    }
+
     promise.set_value(success);
     done = true;
 }
 
+bool AudioRequestImpl::Start(uint64_t start_time_frames)
+{
+    bool is_started = false;
+    {
+        // lock this in case playback finishes earlier than this function finishes execution
+        std::lock_guard lock(req_mtx);
+
+        if (done || !sound) {
+            return false;
+        }
+
+        if (start_time_frames) {
+            ma_sound_set_start_time_in_pcm_frames(&sound.value(), start_time_frames);
+        }
+
+        is_started = ma_sound_start(&sound.value()) == MA_SUCCESS;
+        if (!is_started) {
+            Cancel(false);
+        }
+    }
+
+    // outside the lock, this destroys the request
+    if (!is_started) {
+        remove_from_requests_manager();
+    }
+    return is_started;
+}
+
 
 
 std::list<AudioRequestImpl>::iterator PlaybackRequestsMan::CreateNew()
@@ -171,30 +270,132 @@ void AudioPlayback::UninitPlayback()
     }
 
     playback_requests.CancelAndRemoveAll();
+    close_all_streams();
+    clip_cache.Clear();
     ma_engine_uninit(&playback_device.engine);
     is_playback_inited = false;
 }
 
 AudioRequestImpl* AudioPlayback::SubmitAudio(const char *audio_data, size_t count)
+{
+    return start_prepared(PrepareAudio(audio_data, count));
+}
+
+AudioRequestImpl* AudioPlayback::SubmitAudio(std::shared_ptr<const std::vector<char>> audio_data)
+{
+    return start_prepared(PrepareAudio(std::move(audio_data)));
+}
+
+AudioRequestImpl* AudioPlayback::SubmitPcm(const char *pcm_data, size_t frames_count, RecordingFormat_t format, unsigned char channels, unsigned int sample_rate)
+{
+    return start_prepared(PreparePcm(pcm_data, frames_count, format, channels, sample_rate));
+}
+
+AudioRequestImpl* AudioPlayback::PrepareAudio(const char *audio_data, size_t count)
 {
     if (!is_playback_inited) {
         return {};
     }
 
+    if (auto pcm = cached_clip(audio_data, count)) {
+        return prepare_pcm(std::move(pcm), ma_format_f32, ma_engine_get_channels(&playback_device.engine), ma_engine_get_sample_rate(&playback_device.engine));
+    }
+    return prepare_encoded(std::make_shared<const std::vector<char>>(audio_data, audio_data + count));
+}
+
+AudioRequestImpl* AudioPlayback::PrepareAudio(std::shared_ptr<const std::vector<char>> audio_data)
+{
+    if (!is_playback_inited || !audio_data) {
+        return {};
+    }
+
+    if (auto pcm = cached_clip(audio_data->data(), audio_data->size())) {
+        return prepare_pcm(std::move(pcm), ma_format_f32, ma_engine_get_channels(&playback_device.engine), ma_engine_get_sample_rate(&playback_device.engine));
+    }
+    return prepare_encoded(std::move(audio_data));
+}
+
+AudioRequestImpl* AudioPlayback::PreparePcm(const char *pcm_data, size_t frames_count, RecordingFormat_t format, unsigned char channels, unsigned int sample_rate)
+{
+    if (!is_playback_inited) {
+        return {};
+    }
+
+    const auto pcm_format = to_ma_format(format);
+    const auto frame_bytes = ma_get_bytes_per_frame(pcm_format, channels);
+    if (!frame_bytes || !sample_rate || !frames_count) {
+        return nullptr;
+    }
+
+    return prepare_pcm(std::make_shared<const std::vector<char>>(pcm_data, pcm_data + frames_count * frame_bytes), pcm_format, channels, sample_rate);
+}
+
+std::shared_ptr<const std::vector<char>> AudioPlayback::cached_clip(const char *audio_data, size_t count)
+{
+    if (!clip_cache.IsEnabled()) {
+        return {};
+    }
+
+    const auto key = ClipCache::Key(audio_data, count);
+    bool is_uncacheable = false;
+    if (auto pcm = clip_cache.Find(key, is_uncacheable)) {
+        return pcm;
+    }
+    if (is_uncacheable) {
+        return {};
+    }
+
+    size_t decoded_bytes = 0;
+    auto pcm = decode_clip(&playback_device.engine, audio_data, count, clip_cache.GetBudget(), decoded_bytes);
+    if (pcm) {
+        clip_cache.Insert(key, pcm);
+    } else {
+        clip_cache.Reject(key, decoded_bytes);
+    }
+    return pcm;
+}
+
+AudioRequestImpl* AudioPlayback::prepare_encoded(std::shared_ptr<const std::vector<char>> audio_data)
+{
     auto req = playback_requests.CreateNew();
 
-    req->data.assign(audio_data, audio_data + count);
+    req->data = std::move(audio_data);
 
     req->decoder = ma_decoder{};
-    if (ma_decoder_init_memory(req->data.data(), req->data.size(), nullptr, &req->decoder.value()) != MA_SUCCESS) {
+    if (ma_decoder_init_memory(req->data->data(), req->data->size(), nullptr, &req->decoder.value()) != MA_SUCCESS) {
         req->decoder = {};
         req->Cancel(false);
         req->remove_from_requests_manager();
         return nullptr;
     }
 
+    return prepare_request(req, static_cast<ma_data_source *>(&req->decoder.value()));
+}
+
+AudioRequestImpl* AudioPlayback::prepare_pcm(std::shared_ptr<const std::vector<char>> pcm, ma_format format, ma_uint32 channels, ma_uint32 sample_rate)
+{
+    auto req = playback_requests.CreateNew();
+
+    req->data = std::move(pcm);
+    const auto frames_count = req->data->size() / ma_get_bytes_per_frame(format, channels);
+
+    // no container to probe, the samples are played as they are
+    req->buffer_ref = ma_audio_buffer_ref{};
+    if (ma_audio_buffer_ref_init(format, channels, req->data->data(), frames_count, &req->buffer_ref.value()) != MA_SUCCESS) {
+        req->buffer_ref = {};
+        req->Cancel(false);
+        req->remove_from_requests_manager();
+        return nullptr;
+    }
+    req->buffer_ref.value().sampleRate = sample_rate; // the init doesn't take it, 0 would mean the engine's rate
+
+    return prepare_request(req, static_cast<ma_data_source *>(&req->buffer_ref.value()));
+}
+
+AudioRequestImpl* AudioPlayback::prepare_request(std::list<AudioRequestImpl>::iterator req, ma_data_source *source)
+{
     req->cfg = ma_sound_config_init();
-    req->cfg.value().pDataSource = static_cast<ma_data_source *>(&req->decoder.value());
+    req->cfg.value().pDataSource = source;
     req->cfg.value().pEndCallbackUserData = &*req;
     req->cfg.value().endCallback = [](void *pUserData, ma_sound *pSound){
         std::thread([pUserData](){ // on a separate thread because in the docs it mentioned we can't call xxx_uninit() in the callback
@@ -214,16 +415,86 @@ AudioRequestImpl* AudioPlayback::SubmitAudio(const char *audio_data, size_t coun
     
     // ma_sound_set_spatialization_enabled(&req->sound.value(), MA_FALSE);
 
-    // lock this in case playback finished earlier than this function finishes execution
-    std::lock_guard req_lock(req->req_mtx);
+    return &*req;
+}
 
-    if (ma_sound_start(&req->sound.value()) != MA_SUCCESS) {
-        req->Cancel(false);
-        req->remove_from_requests_manager();
+AudioRequestImpl* AudioPlayback::start_prepared(AudioRequestImpl *req)
+{
+    if (!req || !req->Start(0)) {
         return nullptr;
     }
+    return req;
+}
 
-    return &*req;
+void AudioPlayback::close_all_streams()
+{
+    std::lock_guard lock(streams_mtx);
+
+    for (auto &stream : streams) {
+        if (auto alive = stream.lock()) {
+            alive->Close();
+        }
+    }
+    streams.clear();
+}
+
+std::shared_ptr<PlaybackStream> AudioPlayback::OpenStream(RecordingFormat_t format, unsigned char channels, unsigned int sample_rate, unsigned int buffer_ms)
+{
+    if (!is_playback_inited) {
+        return {};
+    }
+
+    const auto pcm_format = to_ma_format(format);
+    if (pcm_format == ma_format_unknown) {
+        return {};
+    }
+
+    auto stream = std::make_shared<PlaybackStream>();
+    const auto buffer_frames = static_cast<size_t>(sample_rate) * buffer_ms / 1000;
+    if (!stream->Open(&playback_device.engine, pcm_format, channels, sample_rate, buffer_frames)) {
+        return {};
+    }
+
+    std::lock_guard lock(streams_mtx);
+    std::erase_if(streams, [](const auto &item){ return item.expired(); });
+    streams.emplace_back(stream);
+    return stream;
+}
+
+uint64_t AudioPlayback::GetTimeFrames() const
+{
+    if (!is_playback_inited) {
+        return 0;
+    }
+    return ma_engine_get_time_in_pcm_frames(&playback_device.engine);
+}
+
+unsigned int AudioPlayback::GetSampleRate() const
+{
+    if (!is_playback_inited) {
+        return 0;
+    }
+    return ma_engine_get_sample_rate(&playback_device.engine);
+}
+
+void AudioPlayback::SetCacheBudget(size_t max_bytes)
+{
+    clip_cache.SetBudget(max_bytes);
+}
+
+size_t AudioPlayback::GetCacheBudget() const
+{
+    return clip_cache.GetBudget();
+}
+
+PlaybackCacheStats_t AudioPlayback::GetCacheStats() const
+{
+    return clip_cache.GetStats();
+}
+
+void AudioPlayback::ClearCache()
+{
+    clip_cache.Clear();
 }
 
 void AudioPlayback::SetPlaybackVolumePercent(float sound_volume_percent)
@@ -31,9 +31,15 @@ For more information, please refer to <https://unlicense.org>
 #include <vector>
 #include <list>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <cstring> // size_t
+#include <cstdint> // uintxx_t
 
+#include "../../audio_man.hpp"
 #include "miniaudio/miniaudio.h"
+#include "playback_stream/playback_stream.hpp"
+#include "clip_cache/clip_cache.hpp"
 
 
 class AudioPlayback;
@@ -48,10 +54,13 @@ private:
     std::optional<ma_decoder> decoder{};
     std::optional<ma_sound_config> cfg{};
     // ----
+
+    // used when playing raw pcm
+    std::optional<ma_audio_buffer_ref> buffer_ref{};
     
     std::optional<ma_sound> sound{};
 
-    std::vector<char> data{};
+    std::shared_ptr<const std::vector<char>> data{}; // shared by every request playing the same buffer
 
     std::promise<bool> promise{};
     std::shared_future<bool> future_result{};
@@ -77,6 +86,8 @@ public:
 
     std::shared_future<bool> FutureResult() const;
     void Cancel(bool success);
+    // 'start_time_frames' is an engine time, 0 = now
+    bool Start(uint64_t start_time_frames);
 };
 
 class PlaybackRequestsMan
@@ -106,6 +117,20 @@ private:
     PlaybackDevice_t playback_device{};
     bool is_playback_inited = false;
 
+    // closed by UninitPlayback() if still alive, otherwise by their last handle
+    std::list<std::weak_ptr<PlaybackStream>> streams{};
+    std::mutex streams_mtx{};
+
+    // cleared by UninitPlayback(), the next device may use another format
+    ClipCache clip_cache{};
+
+    void close_all_streams();
+    std::shared_ptr<const std::vector<char>> cached_clip(const char *audio_data, size_t count);
+    AudioRequestImpl* prepare_encoded(std::shared_ptr<const std::vector<char>> audio_data);
+    AudioRequestImpl* prepare_pcm(std::shared_ptr<const std::vector<char>> pcm, ma_format format, ma_uint32 channels, ma_uint32 sample_rate);
+    AudioRequestImpl* prepare_request(std::list<AudioRequestImpl>::iterator req, ma_data_source *source);
+    AudioRequestImpl* start_prepared(AudioRequestImpl *req);
+
 public:
     ~AudioPlayback();
 
@@ -113,6 +138,20 @@ public:
     void UninitPlayback();
 
     AudioRequestImpl* SubmitAudio(const char *audio_data, size_t count);
+    AudioRequestImpl* SubmitAudio(std::shared_ptr<const std::vector<char>> audio_data);
+    AudioRequestImpl* SubmitPcm(const char *pcm_data, size_t frames_count, RecordingFormat_t format, unsigned char channels, unsigned int sample_rate);
+    // same as the Submit*() ones without starting the sound, see AudioRequestImpl::Start()
+    AudioRequestImpl* PrepareAudio(const char *audio_data, size_t count);
+    AudioRequestImpl* PrepareAudio(std::shared_ptr<const std::vector<char>> audio_data);
+    AudioRequestImpl* PreparePcm(const char *pcm_data, size_t frames_count, RecordingFormat_t format, unsigned char channels, unsigned int sample_rate);
+    uint64_t GetTimeFrames() const;
+    unsigned int GetSampleRate() const;
+    std::shared_ptr<PlaybackStream> OpenStream(RecordingFormat_t format, unsigned char channels, unsigned int sample_rate, unsigned int buffer_ms);
+
+    void SetCacheBudget(size_t max_bytes);
+    size_t GetCacheBudget() const;
+    PlaybackCacheStats_t GetCacheStats() const;
+    void ClearCache();
 
     void SetPlaybackVolumePercent(float sound_volume_percent);
     float GetPlaybackVolumePercent() const;
@@ -0,0 +1,210 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#include <algorithm>
+
+#include "playback_stream.hpp"
+
+
+
+ma_result PlaybackStream::on_read(ma_data_source *pDataSource, void *pFramesOut, ma_uint64 frameCount, ma_uint64 *pFramesRead)
+{
+    auto stream = static_cast<PlaybackStreamSource_t *>(pDataSource)->owner;
+    auto out = static_cast<char *>(pFramesOut);
+
+    // only whole frames are ever written so only whole frames are read
+    const auto read_frames = stream->ring.PopBulk(out, frameCount * stream->frame_bytes) / stream->frame_bytes;
+    if (read_frames < frameCount) {
+        ma_silence_pcm_frames(out + read_frames * stream->frame_bytes, frameCount - read_frames, stream->format, stream->channels);
+        if (!stream->is_starved) {
+            stream->underruns_count.fetch_add(1, std::memory_order_relaxed);
+            stream->is_starved = true;
+        }
+    } else {
+        stream->is_starved = false;
+    }
+
+    // never reports the end, the voice lives until Close()
+    stream->frames_read.fetch_add(frameCount, std::memory_order_relaxed);
+    if (pFramesRead) {
+        *pFramesRead = frameCount;
+    }
+    return MA_SUCCESS;
+}
+
+ma_result PlaybackStream::on_seek(ma_data_source *pDataSource, ma_uint64 frameIndex)
+{
+    (void)pDataSource;
+    (void)frameIndex;
+    return MA_NOT_IMPLEMENTED;
+}
+
+ma_result PlaybackStream::on_get_data_format(ma_data_source *pDataSource, ma_format *pFormat, ma_uint32 *pChannels, ma_uint32 *pSampleRate, ma_channel *pChannelMap, size_t channelMapCap)
+{
+    auto stream = static_cast<PlaybackStreamSource_t *>(pDataSource)->owner;
+
+    if (pFormat) {
+        *pFormat = stream->format;
+    }
+    if (pChannels) {
+        *pChannels = stream->channels;
+    }
+    if (pSampleRate) {
+        *pSampleRate = stream->sample_rate;
+    }
+    if (pChannelMap) {
+        ma_channel_map_init_standard(ma_standard_channel_map_default, pChannelMap, channelMapCap, stream->channels);
+    }
+    return MA_SUCCESS;
+}
+
+ma_result PlaybackStream::on_get_cursor(ma_data_source *pDataSource, ma_uint64 *pCursor)
+{
+    auto stream = static_cast<PlaybackStreamSource_t *>(pDataSource)->owner;
+
+    *pCursor = stream->frames_read.load(std::memory_order_relaxed);
+    return MA_SUCCESS;
+}
+
+ma_result PlaybackStream::on_get_length(ma_data_source *pDataSource, ma_uint64 *pLength)
+{
+    (void)pDataSource;
+
+    *pLength = 0; // unknown
+    return MA_NOT_IMPLEMENTED;
+}
+
+PlaybackStream::~PlaybackStream()
+{
+    Close();
+}
+
+bool PlaybackStream::Open(ma_engine *engine, ma_format pcm_format, ma_uint32 pcm_channels, ma_uint32 pcm_sample_rate, size_t buffer_frames)
+{
+    static const ma_data_source_vtable vtable = []{
+        ma_data_source_vtable callbacks{};
+        callbacks.onRead = on_read;
+        callbacks.onSeek = on_seek;
+        callbacks.onGetDataFormat = on_get_data_format;
+        callbacks.onGetCursor = on_get_cursor;
+        callbacks.onGetLength = on_get_length;
+        return callbacks;
+    }();
+
+    std::lock_guard lock(mtx);
+
+    if (sound) {
+        return false;
+    }
+
+    frame_bytes = ma_get_bytes_per_frame(pcm_format, pcm_channels);
+    if (!frame_bytes || !pcm_sample_rate) {
+        frame_bytes = 0;
+        return false;
+    }
+
+    format = pcm_format;
+    channels = pcm_channels;
+    sample_rate = pcm_sample_rate;
+    max_queued_bytes = std::max<size_t>(buffer_frames, 1) * frame_bytes;
+    ring.Reset(max_queued_bytes);
+    is_starved = true;
+    underruns_count.store(0, std::memory_order_relaxed);
+    frames_read.store(0, std::memory_order_relaxed);
+
+    source.owner = this;
+    auto source_cfg = ma_data_source_config_init();
+    source_cfg.vtable = &vtable;
+    if (ma_data_source_init(&source_cfg, &source.base) != MA_SUCCESS) {
+        return false;
+    }
+
+    auto cfg = ma_sound_config_init();
+    cfg.pDataSource = static_cast<ma_data_source *>(&source);
+
+    sound = ma_sound{};
+    if (ma_sound_init_ex(engine, &cfg, &sound.value()) != MA_SUCCESS) {
+        sound = {};
+        ma_data_source_uninit(&source.base);
+        return false;
+    }
+
+    if (ma_sound_start(&sound.value()) != MA_SUCCESS) {
+        ma_sound_uninit(&sound.value());
+        sound = {};
+        ma_data_source_uninit(&source.base);
+        return false;
+    }
+
+    is_open.store(true, std::memory_order_release);
+    return true;
+}
+
+void PlaybackStream::Close()
+{
+    std::lock_guard lock(mtx);
+
+    if (!sound) {
+        return;
+    }
+
+    is_open.store(false, std::memory_order_release);
+    ma_sound_uninit(&sound.value());
+    sound = {};
+    ma_data_source_uninit(&source.base);
+}
+
+bool PlaybackStream::IsOpen() const
+{
+    return is_open.load(std::memory_order_acquire);
+}
+
+size_t PlaybackStream::Write(const char *data, size_t bytes)
+{
+    if (!IsOpen()) {
+        return 0;
+    }
+
+    const auto free_bytes = max_queued_bytes - std::min(ring.Size(), max_queued_bytes);
+    return ring.PushBulk(data, std::min(bytes, free_bytes) / frame_bytes * frame_bytes);
+}
+
+size_t PlaybackStream::SizeQueued() const
+{
+    return ring.Size();
+}
+
+size_t PlaybackStream::FrameBytes() const
+{
+    return frame_bytes;
+}
+
+uint64_t PlaybackStream::UnderrunsCount() const
+{
+    return underruns_count.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,94 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#pragma once
+
+#include <optional>
+#include <atomic>
+#include <mutex>
+#include <cstring> // size_t
+#include <cstdint> // uintxx_t
+
+#include "miniaudio/miniaudio.h"
+#include "../../spsc_ring/spsc_ring.hpp"
+
+
+class PlaybackStream;
+
+// what miniaudio sees as the data source, the base must come first
+struct PlaybackStreamSource_t {
+    ma_data_source_base base{};
+    PlaybackStream *owner{};
+};
+
+// persistent voice playing raw pcm written by the caller
+// the audio thread reads the pcm from a lock-free byte ring and plays silence whenever it runs short
+class PlaybackStream
+{
+private:
+    PlaybackStreamSource_t source{};
+    SpscRing<char> ring{};
+
+    ma_format format = ma_format_unknown;
+    ma_uint32 channels{};
+    ma_uint32 sample_rate{};
+    size_t frame_bytes{};
+    size_t max_queued_bytes{}; // the ring is rounded up to a power of 2, writes stop at the requested size
+
+    std::optional<ma_sound> sound{};
+    std::mutex mtx{}; // Open()/Close()
+
+    std::atomic<bool> is_open{};
+
+    bool is_starved = true; // audio thread only, an underrun is counted when playing pcm runs out, not while idle
+    std::atomic<uint64_t> underruns_count{};
+    std::atomic<uint64_t> frames_read{};
+
+    static ma_result on_read(ma_data_source *pDataSource, void *pFramesOut, ma_uint64 frameCount, ma_uint64 *pFramesRead);
+    static ma_result on_seek(ma_data_source *pDataSource, ma_uint64 frameIndex);
+    static ma_result on_get_data_format(ma_data_source *pDataSource, ma_format *pFormat, ma_uint32 *pChannels, ma_uint32 *pSampleRate, ma_channel *pChannelMap, size_t channelMapCap);
+    static ma_result on_get_cursor(ma_data_source *pDataSource, ma_uint64 *pCursor);
+    static ma_result on_get_length(ma_data_source *pDataSource, ma_uint64 *pLength);
+
+public:
+    PlaybackStream() = default;
+    PlaybackStream(const PlaybackStream &other) = delete;
+    PlaybackStream& operator=(const PlaybackStream &other) = delete;
+    ~PlaybackStream();
+
+    // 'buffer_frames' of pcm can be queued ahead, the voice starts right away
+    bool Open(ma_engine *engine, ma_format pcm_format, ma_uint32 pcm_channels, ma_uint32 pcm_sample_rate, size_t buffer_frames);
+    void Close();
+    bool IsOpen() const;
+
+    // single producer, queues as many whole frames of 'data' as fit and returns their size in bytes
+    size_t Write(const char *data, size_t bytes);
+    size_t SizeQueued() const; // bytes not played yet
+    size_t FrameBytes() const;
+    uint64_t UnderrunsCount() const;
+};
@@ -0,0 +1,77 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#include <algorithm>
+
+#include "compression_controller.hpp"
+
+
+void CompressionController::Reset()
+{
+    ratio_avg = 0.5;
+    stored_since_probe = 0;
+}
+
+CompressionEffort_t CompressionController::Next(double capture_ring_fill, size_t unread_bytes)
+{
+    if (ratio_avg >= incompressible_ratio) { // noise-like input, only probe once in a while
+        if (++stored_since_probe < probe_interval) {
+            return CompressionEffort_t::Store;
+        }
+
+        stored_since_probe = 0;
+        return CompressionEffort_t::Fast;
+    }
+
+    if (capture_ring_fill >= worker_behind_fill) { // catch up before the audio thread starts dropping chunks
+        return CompressionEffort_t::Fast;
+    }
+
+    if (unread_bytes >= reader_behind_bytes) {
+        return CompressionEffort_t::High;
+    }
+
+    return CompressionEffort_t::Fast;
+}
+
+void CompressionController::Report(size_t original_bytes, size_t compressed_bytes)
+{
+    if (!original_bytes) {
+        return;
+    }
+
+    const auto ratio = compressed_bytes
+        ? std::min(static_cast<double>(compressed_bytes) / static_cast<double>(original_bytes), max_reported_ratio)
+        : max_reported_ratio;
+    if (ratio_avg >= incompressible_ratio && ratio < incompressible_ratio) { // a probe paid off, resume right away
+        ratio_avg = ratio;
+        return;
+    }
+
+    ratio_avg += (ratio - ratio_avg) * ratio_smoothing;
+}
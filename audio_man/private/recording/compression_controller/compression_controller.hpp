@@ -0,0 +1,64 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#pragma once
+
+#include <cstring> // size_t
+
+
+enum class CompressionEffort_t {
+    Store, // keep the chunk raw, compressing it isn't expected to pay off
+    Fast,
+    High, // smaller output for more cpu, used while the reader falls behind
+};
+
+// decides how much effort the compression worker spends on the next chunk
+// from the recently achieved ratio, how full the capture ring is and how much compressed data is waiting for the reader
+// not thread safe, owned by the compression worker
+class CompressionController
+{
+private:
+    static constexpr double ratio_smoothing = 0.125; // weight of the newest chunk in the moving average
+    static constexpr double max_reported_ratio = 1.5; // so a single incompressible chunk can't dominate the average
+    static constexpr double incompressible_ratio = 0.97; // stop compressing above this average ratio
+    static constexpr size_t probe_interval = 32; // chunks stored raw between 2 attempts while the input is incompressible
+    static constexpr double worker_behind_fill = 0.25; // capture ring fill above which only the fast level is used
+    static constexpr size_t reader_behind_bytes = 4 * 1024 * 1024; // unread bytes above which the high level is used
+
+    double ratio_avg = 0.5; // compressed / original, assume compressible input until measured
+    size_t stored_since_probe{};
+
+public:
+    void Reset();
+
+    // 'capture_ring_fill' is the fraction [0, 1] of the capture ring waiting for the worker
+    CompressionEffort_t Next(double capture_ring_fill, size_t unread_bytes);
+
+    // feedback for chunks which were actually compressed, 'compressed_bytes' is 0 when compression failed
+    void Report(size_t original_bytes, size_t compressed_bytes);
+};
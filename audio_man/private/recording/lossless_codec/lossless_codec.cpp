@@ -0,0 +1,740 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#include <cmath> // std::frexp, std::lround
+#include <algorithm>
+#include <bit> // std::bit_width
+
+#include "lossless_codec.hpp"
+
+
+// stream layout:
+// [format u8][channels u8][channel mode u8][reserved u8][frames u32 little-endian]
+// then a bitstream (msb first) with one subframe per channel:
+// [type 2 bits] constant: [sample] | verbatim: [sample]*frames | fixed: [order 3][warm-up samples][residual]
+//               lpc: [order-1 4][precision-1 4][shift 5][coefs]*order [warm-up samples][residual]
+// residual: [partition order 4] then per partition [rice parameter 6][rice codes of the zigzagged residuals]
+
+static constexpr size_t stream_header_bytes = 8;
+
+static constexpr unsigned int subframe_constant = 0;
+static constexpr unsigned int subframe_verbatim = 1;
+static constexpr unsigned int subframe_fixed = 2;
+static constexpr unsigned int subframe_lpc = 3;
+
+static constexpr unsigned int channel_mode_independent = 0;
+static constexpr unsigned int channel_mode_left_side = 1; // 2nd channel stored as left - right
+
+static constexpr unsigned int max_fixed_order = 4;
+static constexpr unsigned int max_lpc_order = 8;
+static constexpr unsigned int lpc_precision = 13; // bits per quantized coefficient, sign included
+static constexpr int max_lpc_shift = 24;
+static constexpr unsigned int max_partition_order = 8;
+static constexpr size_t min_partition_samples = 16;
+static constexpr unsigned int max_rice_parameter = 40;
+static constexpr size_t min_lpc_samples = 32; // shorter blocks don't pay for the coefficients
+static constexpr unsigned int max_residual_headroom = 20; // bits above the sample width, anything larger is corruption
+
+// bits per sample of the supported integer formats, 0 otherwise
+static unsigned int sample_bits(RecordingFormat_t format)
+{
+    switch (format) {
+    case RecordingFormat_t::Unsigned8: return 8;
+    case RecordingFormat_t::Signed16: return 16;
+    case RecordingFormat_t::Signed24: return 24;
+    case RecordingFormat_t::Signed32: return 32;
+
+    default: return 0;
+    }
+}
+
+static uint64_t zigzag_encode(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t zigzag_decode(uint64_t value)
+{
+    return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+static int64_t sign_extend(uint64_t value, unsigned int bits)
+{
+    return static_cast<int64_t>(value << (64 - bits)) >> (64 - bits);
+}
+
+// *** pcm <-> samples *** //
+static void read_samples(const char *pcm, size_t frames, unsigned int channels, unsigned int bits, int64_t *samples)
+{
+    auto bytes = reinterpret_cast<const uint8_t *>(pcm);
+    const auto sample_bytes = bits / 8;
+    for (size_t frame = 0; frame < frames; ++frame) {
+        for (unsigned int ch = 0; ch < channels; ++ch, bytes += sample_bytes) {
+            int64_t value = 0;
+            switch (bits) {
+            case 8: value = static_cast<int64_t>(bytes[0]) - 128; break;
+            case 16: value = static_cast<int16_t>(bytes[0] | (bytes[1] << 8)); break;
+            case 24: value = sign_extend(bytes[0] | (bytes[1] << 8) | (static_cast<uint32_t>(bytes[2]) << 16), 24); break;
+            case 32: value = static_cast<int32_t>(bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24)); break;
+            }
+            samples[ch * frames + frame] = value;
+        }
+    }
+}
+
+static void write_samples(const int64_t *samples, size_t frames, unsigned int channels, unsigned int bits, char *pcm)
+{
+    auto bytes = reinterpret_cast<uint8_t *>(pcm);
+    const auto sample_bytes = bits / 8;
+    for (size_t frame = 0; frame < frames; ++frame) {
+        for (unsigned int ch = 0; ch < channels; ++ch) {
+            auto value = static_cast<uint64_t>(samples[ch * frames + frame]);
+            if (bits == 8) {
+                value += 128;
+            }
+            for (unsigned int idx = 0; idx < sample_bytes; ++idx, ++bytes) {
+                *bytes = static_cast<uint8_t>(value >> (idx * 8));
+            }
+        }
+    }
+}
+// *** pcm <-> samples *** //
+
+// *** bit I/O *** //
+class BitWriter
+{
+private:
+    std::vector<char> &out;
+    uint64_t acc{};
+    unsigned int acc_bits{}; // always < 8 between calls
+
+public:
+    explicit BitWriter(std::vector<char> &out) : out(out) { }
+
+    // bits <= 32
+    void Write(uint64_t value, unsigned int bits)
+    {
+        if (!bits) {
+            return;
+        }
+
+        acc = (acc << bits) | (value & ((1ull << bits) - 1));
+        acc_bits += bits;
+        while (acc_bits >= 8) {
+            acc_bits -= 8;
+            out.push_back(static_cast<char>(acc >> acc_bits));
+        }
+    }
+
+    // bits <= 64
+    void WriteWide(uint64_t value, unsigned int bits)
+    {
+        if (bits > 32) {
+            Write(value >> 32, bits - 32);
+            bits = 32;
+        }
+        Write(value, bits);
+    }
+
+    void WriteRice(uint64_t value, unsigned int parameter)
+    {
+        auto quotient = value >> parameter;
+        while (quotient >= 32) {
+            Write(0, 32);
+            quotient -= 32;
+        }
+        Write(1, static_cast<unsigned int>(quotient) + 1); // 'quotient' zeros then a one
+        WriteWide(value, parameter);
+    }
+
+    // pads the last byte with zeros
+    void Flush()
+    {
+        if (acc_bits) {
+            out.push_back(static_cast<char>(acc << (8 - acc_bits)));
+            acc_bits = 0;
+        }
+    }
+};
+
+class BitReader
+{
+private:
+    const uint8_t *data{};
+    size_t size{};
+    size_t pos{};
+    uint64_t cache{};
+    unsigned int cache_bits{}; // valid low bits of 'cache'
+    bool ok = true;
+
+    void refill()
+    {
+        while (cache_bits <= 56 && pos < size) {
+            cache = (cache << 8) | data[pos++];
+            cache_bits += 8;
+        }
+    }
+
+public:
+    BitReader(const char *data, size_t size) : data(reinterpret_cast<const uint8_t *>(data)), size(size) { }
+
+    bool Ok() const
+    {
+        return ok;
+    }
+
+    // bits <= 32
+    uint64_t Read(unsigned int bits)
+    {
+        if (!bits) {
+            return 0;
+        }
+
+        if (cache_bits < bits) {
+            refill();
+            if (cache_bits < bits) {
+                ok = false;
+                return 0;
+            }
+        }
+
+        cache_bits -= bits;
+        return (cache >> cache_bits) & ((1ull << bits) - 1);
+    }
+
+    // bits <= 64
+    uint64_t ReadWide(unsigned int bits)
+    {
+        uint64_t value = 0;
+        if (bits > 32) {
+            value = Read(bits - 32) << 32;
+            bits = 32;
+        }
+        return value | Read(bits);
+    }
+
+    int64_t ReadSigned(unsigned int bits)
+    {
+        return sign_extend(ReadWide(bits), bits);
+    }
+
+    uint64_t ReadRice(unsigned int parameter)
+    {
+        uint64_t quotient = 0;
+        while (ok && !Read(1)) {
+            ++quotient;
+        }
+        return (quotient << parameter) | ReadWide(parameter);
+    }
+};
+// *** bit I/O *** //
+
+// *** prediction *** //
+struct ChannelPlan_t
+{
+    unsigned int type = subframe_verbatim;
+    unsigned int order{};
+    int shift{};
+    int32_t coefs[max_lpc_order]{};
+    unsigned int partition_order{};
+    size_t bits{};
+};
+
+static int64_t predict_fixed(const int64_t *x, size_t idx, unsigned int order)
+{
+    switch (order) {
+    case 1: return x[idx - 1];
+    case 2: return 2 * x[idx - 1] - x[idx - 2];
+    case 3: return 3 * x[idx - 1] - 3 * x[idx - 2] + x[idx - 3];
+    case 4: return 4 * x[idx - 1] - 6 * x[idx - 2] + 4 * x[idx - 3] - x[idx - 4];
+
+    default: return 0;
+    }
+}
+
+static int64_t predict_lpc(const int64_t *x, size_t idx, const ChannelPlan_t &plan)
+{
+    int64_t sum = 0;
+    for (unsigned int j = 0; j < plan.order; ++j) {
+        sum += static_cast<int64_t>(plan.coefs[j]) * x[idx - 1 - j];
+    }
+    return sum >> plan.shift;
+}
+
+// residuals[0, n - order)
+static void compute_residuals(const int64_t *x, size_t n, const ChannelPlan_t &plan, int64_t *residuals)
+{
+    if (plan.type == subframe_lpc) {
+        for (size_t idx = plan.order; idx < n; ++idx) {
+            residuals[idx - plan.order] = x[idx] - predict_lpc(x, idx, plan);
+        }
+    } else {
+        for (size_t idx = plan.order; idx < n; ++idx) {
+            residuals[idx - plan.order] = x[idx] - predict_fixed(x, idx, plan.order);
+        }
+    }
+}
+
+static unsigned int rice_parameter(uint64_t sum, size_t count)
+{
+    const auto mean = count ? sum / count : 0;
+    const auto parameter = mean ? static_cast<unsigned int>(std::bit_width(mean)) - 1 : 0;
+    return std::min(parameter, max_rice_parameter);
+}
+
+// estimated, the quotients are approximated from the partition sum
+static size_t rice_partition_bits(uint64_t sum, size_t count)
+{
+    const auto parameter = rice_parameter(sum, count);
+    return 6 + count * (parameter + 1) + static_cast<size_t>(sum >> parameter);
+}
+
+static size_t partition_begin(size_t partition, size_t count, unsigned int partition_order)
+{
+    return (partition * count) >> partition_order;
+}
+
+// picks the partition order with the least estimated bits
+static size_t residual_bits(const int64_t *residuals, size_t count, unsigned int &best_partition_order)
+{
+    unsigned int top_order = 0;
+    while (top_order < max_partition_order && (count >> (top_order + 1)) >= min_partition_samples) {
+        ++top_order;
+    }
+
+    // sums of the finest partitions, merged pairwise for the coarser orders
+    uint64_t sums[1u << max_partition_order]{};
+    auto partitions = size_t{1} << top_order;
+    for (size_t partition = 0; partition < partitions; ++partition) {
+        const auto end = partition_begin(partition + 1, count, top_order);
+        for (auto idx = partition_begin(partition, count, top_order); idx < end; ++idx) {
+            sums[partition] += zigzag_encode(residuals[idx]);
+        }
+    }
+
+    auto best_bits = SIZE_MAX;
+    for (auto order = static_cast<int>(top_order); order >= 0; --order) {
+        partitions = size_t{1} << order;
+        size_t bits = 4;
+        for (size_t partition = 0; partition < partitions; ++partition) {
+            bits += rice_partition_bits(sums[partition], partition_begin(partition + 1, count, order) - partition_begin(partition, count, order));
+        }
+
+        if (bits <= best_bits) {
+            best_bits = bits;
+            best_partition_order = static_cast<unsigned int>(order);
+        }
+
+        for (size_t partition = 0; partition < partitions / 2; ++partition) {
+            sums[partition] = sums[2 * partition] + sums[2 * partition + 1];
+        }
+    }
+
+    return best_bits;
+}
+
+// FLAC's Levinson-Durbin recursion, 'coefs[order - 1]' predicts x[n] = sum(coefs[order - 1][j] * x[n - 1 - j])
+static unsigned int levinson_durbin(const double *autoc, unsigned int max_order, double coefs[max_lpc_order][max_lpc_order])
+{
+    double lpc[max_lpc_order]{};
+    auto err = autoc[0];
+
+    for (unsigned int i = 0; i < max_order; ++i) {
+        auto r = -autoc[i + 1];
+        for (unsigned int j = 0; j < i; ++j) {
+            r -= lpc[j] * autoc[i - j];
+        }
+        r /= err;
+
+        lpc[i] = r;
+        for (unsigned int j = 0; j < i / 2; ++j) {
+            const auto tmp = lpc[j];
+            lpc[j] += r * lpc[i - 1 - j];
+            lpc[i - 1 - j] += r * tmp;
+        }
+        if (i & 1) {
+            lpc[i / 2] += lpc[i / 2] * r;
+        }
+
+        for (unsigned int j = 0; j <= i; ++j) {
+            coefs[i][j] = -lpc[j];
+        }
+
+        err *= 1.0 - r * r;
+        if (err <= 0) { // perfectly predictable, higher orders won't help
+            return i + 1;
+        }
+    }
+
+    return max_order;
+}
+
+static bool quantize_coefs(const double *coefs, unsigned int order, ChannelPlan_t &plan)
+{
+    double cmax = 0;
+    for (unsigned int j = 0; j < order; ++j) {
+        cmax = std::max(cmax, std::fabs(coefs[j]));
+    }
+    if (!(cmax > 0) || !std::isfinite(cmax)) {
+        return false;
+    }
+
+    int log2cmax = 0;
+    std::frexp(cmax, &log2cmax);
+    const auto shift = std::min(static_cast<int>(lpc_precision) - 1 - log2cmax, max_lpc_shift);
+    if (shift < 0) {
+        return false;
+    }
+
+    // carry the rounding error over to the next coefficient
+    const auto qmax = (1 << (lpc_precision - 1)) - 1;
+    double error = 0;
+    for (unsigned int j = 0; j < order; ++j) {
+        error += coefs[j] * (1 << shift);
+        const auto q = std::clamp(static_cast<int32_t>(std::lround(error)), -qmax - 1, qmax);
+        plan.coefs[j] = q;
+        error -= q;
+    }
+
+    plan.type = subframe_lpc;
+    plan.order = order;
+    plan.shift = shift;
+    return true;
+}
+// *** prediction *** //
+
+
+
+// bits of the subframe without its residual
+static size_t subframe_header_bits(const ChannelPlan_t &plan, unsigned int width)
+{
+    switch (plan.type) {
+    case subframe_fixed: return 2 + 3 + plan.order * width;
+    case subframe_lpc: return 2 + 4 + 4 + 5 + plan.order * (lpc_precision + width);
+
+    default: return 2;
+    }
+}
+
+static void evaluate_plan(const int64_t *x, size_t n, unsigned int width, ChannelPlan_t &candidate, int64_t *residuals, ChannelPlan_t &best)
+{
+    compute_residuals(x, n, candidate, residuals);
+    candidate.bits = subframe_header_bits(candidate, width) + residual_bits(residuals, n - candidate.order, candidate.partition_order);
+    if (candidate.bits < best.bits) {
+        best = candidate;
+    }
+}
+
+static ChannelPlan_t plan_channel(const int64_t *x, size_t n, unsigned int width, int64_t *residuals, std::vector<double> &windowed)
+{
+    auto best = ChannelPlan_t{};
+    best.type = subframe_verbatim;
+    best.bits = 2 + n * width;
+
+    if (std::all_of(x, x + n, [first = x[0]](int64_t value){ return value == first; })) {
+        best.type = subframe_constant;
+        best.bits = 2 + width;
+        return best;
+    }
+
+    // fixed predictors, the order is picked from the sum of absolute residuals like FLAC does
+    if (n > max_fixed_order) {
+        uint64_t abs_sums[max_fixed_order + 1]{};
+        for (size_t idx = max_fixed_order; idx < n; ++idx) {
+            for (unsigned int order = 0; order <= max_fixed_order; ++order) {
+                const auto residual = x[idx] - predict_fixed(x, idx, order);
+                abs_sums[order] += static_cast<uint64_t>(residual < 0 ? -residual : residual);
+            }
+        }
+
+        auto candidate = ChannelPlan_t{};
+        candidate.type = subframe_fixed;
+        candidate.order = static_cast<unsigned int>(std::min_element(abs_sums, abs_sums + max_fixed_order + 1) - abs_sums);
+        evaluate_plan(x, n, width, candidate, residuals, best);
+    }
+
+    // linear prediction over a welch windowed copy
+    if (n >= min_lpc_samples) {
+        windowed.resize(n);
+        const auto half = (static_cast<double>(n) - 1) / 2;
+        for (size_t idx = 0; idx < n; ++idx) {
+            const auto pos = (static_cast<double>(idx) - half) / half;
+            windowed[idx] = static_cast<double>(x[idx]) * (1.0 - pos * pos);
+        }
+
+        double autoc[max_lpc_order + 1]{};
+        for (unsigned int lag = 0; lag <= max_lpc_order; ++lag) {
+            double sum = 0;
+            for (size_t idx = lag; idx < n; ++idx) {
+                sum += windowed[idx] * windowed[idx - lag];
+            }
+            autoc[lag] = sum;
+        }
+
+        if (autoc[0] > 0) {
+            double coefs[max_lpc_order][max_lpc_order]{};
+            const auto orders = levinson_durbin(autoc, max_lpc_order, coefs);
+            for (unsigned int order = 2; order <= orders; order *= 2) {
+                auto candidate = ChannelPlan_t{};
+                if (quantize_coefs(coefs[order - 1], order, candidate)) {
+                    evaluate_plan(x, n, width, candidate, residuals, best);
+                }
+            }
+        }
+    }
+
+    return best;
+}
+
+static void write_residuals(BitWriter &writer, const int64_t *residuals, size_t count, unsigned int partition_order)
+{
+    writer.Write(partition_order, 4);
+    const auto partitions = size_t{1} << partition_order;
+    for (size_t partition = 0; partition < partitions; ++partition) {
+        const auto begin = partition_begin(partition, count, partition_order);
+        const auto end = partition_begin(partition + 1, count, partition_order);
+
+        uint64_t sum = 0;
+        for (auto idx = begin; idx < end; ++idx) {
+            sum += zigzag_encode(residuals[idx]);
+        }
+
+        const auto parameter = rice_parameter(sum, end - begin);
+        writer.Write(parameter, 6);
+        for (auto idx = begin; idx < end; ++idx) {
+            writer.WriteRice(zigzag_encode(residuals[idx]), parameter);
+        }
+    }
+}
+
+static void write_subframe(BitWriter &writer, const int64_t *x, size_t n, unsigned int width, const ChannelPlan_t &plan, int64_t *residuals)
+{
+    writer.Write(plan.type, 2);
+    switch (plan.type) {
+    case subframe_constant:
+        writer.WriteWide(static_cast<uint64_t>(x[0]), width);
+        return;
+
+    case subframe_verbatim:
+        for (size_t idx = 0; idx < n; ++idx) {
+            writer.WriteWide(static_cast<uint64_t>(x[idx]), width);
+        }
+        return;
+
+    case subframe_fixed:
+        writer.Write(plan.order, 3);
+        break;
+
+    case subframe_lpc:
+        writer.Write(plan.order - 1, 4);
+        writer.Write(lpc_precision - 1, 4);
+        writer.Write(static_cast<uint64_t>(plan.shift), 5);
+        for (unsigned int j = 0; j < plan.order; ++j) {
+            writer.Write(static_cast<uint64_t>(static_cast<int64_t>(plan.coefs[j])), lpc_precision);
+        }
+        break;
+    }
+
+    for (size_t idx = 0; idx < plan.order; ++idx) { // warm-up
+        writer.WriteWide(static_cast<uint64_t>(x[idx]), width);
+    }
+
+    compute_residuals(x, n, plan, residuals);
+    write_residuals(writer, residuals, n - plan.order, plan.partition_order);
+}
+
+static bool read_subframe(BitReader &reader, int64_t *x, size_t n, unsigned int width)
+{
+    auto plan = ChannelPlan_t{};
+    plan.type = static_cast<unsigned int>(reader.Read(2));
+    switch (plan.type) {
+    case subframe_constant:
+        std::fill(x, x + n, reader.ReadSigned(width));
+        return reader.Ok();
+
+    case subframe_verbatim:
+        for (size_t idx = 0; idx < n; ++idx) {
+            x[idx] = reader.ReadSigned(width);
+        }
+        return reader.Ok();
+
+    case subframe_fixed:
+        plan.order = static_cast<unsigned int>(reader.Read(3));
+        if (plan.order > max_fixed_order) {
+            return false;
+        }
+        break;
+
+    case subframe_lpc: {
+        plan.order = static_cast<unsigned int>(reader.Read(4)) + 1;
+        const auto precision = static_cast<unsigned int>(reader.Read(4)) + 1;
+        plan.shift = static_cast<int>(reader.Read(5));
+        if (plan.order > max_lpc_order) {
+            return false;
+        }
+        for (unsigned int j = 0; j < plan.order; ++j) {
+            plan.coefs[j] = static_cast<int32_t>(reader.ReadSigned(precision));
+        }
+    }
+    break;
+    }
+
+    if (plan.order > n || !reader.Ok()) {
+        return false;
+    }
+
+    for (size_t idx = 0; idx < plan.order; ++idx) { // warm-up
+        x[idx] = reader.ReadSigned(width);
+    }
+
+    const auto count = n - plan.order;
+    const auto partition_order = static_cast<unsigned int>(reader.Read(4));
+    if (partition_order > max_partition_order) {
+        return false;
+    }
+
+    const auto partitions = size_t{1} << partition_order;
+    for (size_t partition = 0; partition < partitions && reader.Ok(); ++partition) {
+        const auto parameter = static_cast<unsigned int>(reader.Read(6));
+        const auto end = plan.order + partition_begin(partition + 1, count, partition_order);
+        for (auto idx = plan.order + partition_begin(partition, count, partition_order); idx < end; ++idx) {
+            // bounds checked so corrupted streams can't overflow the prediction of the next samples
+            const auto code = reader.ReadRice(parameter);
+            if (code >> (width + max_residual_headroom)) {
+                return false;
+            }
+            x[idx] = zigzag_decode(code) + (plan.type == subframe_lpc ? predict_lpc(x, idx, plan) : predict_fixed(x, idx, plan.order));
+            if (x[idx] != sign_extend(static_cast<uint64_t>(x[idx]), width)) {
+                return false;
+            }
+        }
+    }
+
+    return reader.Ok();
+}
+
+
+
+size_t LosslessEncoder::Encode(const char *pcm, size_t bytes, RecordingFormat_t format, unsigned int channels, std::vector<char> &out)
+{
+    const auto bits = sample_bits(format);
+    if (!pcm || !bits || !channels || channels > UINT8_MAX) {
+        return 0;
+    }
+
+    const auto frame_bytes = static_cast<size_t>(channels) * (bits / 8);
+    const auto frames = bytes / frame_bytes;
+    if (!frames || bytes % frame_bytes || frames > UINT32_MAX) {
+        return 0;
+    }
+
+    samples.resize(frames * channels);
+    residuals.resize(frames);
+    read_samples(pcm, frames, channels, bits, samples.data());
+
+    // left/side when it's cheaper than coding the right channel as is, side needs 1 more bit
+    auto channel_mode = channel_mode_independent;
+    ChannelPlan_t plans[2]{};
+    if (channels == 2) {
+        const auto left = samples.data();
+        const auto right = left + frames;
+        side_samples.resize(frames);
+        for (size_t idx = 0; idx < frames; ++idx) {
+            side_samples[idx] = left[idx] - right[idx];
+        }
+
+        plans[0] = plan_channel(right, frames, bits, residuals.data(), windowed);
+        plans[1] = plan_channel(side_samples.data(), frames, bits + 1, residuals.data(), windowed);
+        if (plans[1].bits < plans[0].bits) {
+            channel_mode = channel_mode_left_side;
+            std::copy(side_samples.begin(), side_samples.end(), right);
+        }
+    }
+
+    out.clear();
+    out.reserve(stream_header_bytes + bytes + bytes / 8);
+    out.push_back(static_cast<char>(format));
+    out.push_back(static_cast<char>(channels));
+    out.push_back(static_cast<char>(channel_mode));
+    out.push_back(0);
+    for (unsigned int idx = 0; idx < 4; ++idx) {
+        out.push_back(static_cast<char>(static_cast<uint32_t>(frames) >> (idx * 8)));
+    }
+
+    auto writer = BitWriter(out);
+    for (unsigned int ch = 0; ch < channels; ++ch) {
+        const auto x = samples.data() + ch * frames;
+        const auto width = (ch == 1 && channel_mode == channel_mode_left_side) ? bits + 1 : bits;
+        const auto plan = (ch == 1 && channels == 2) ? plans[channel_mode] : plan_channel(x, frames, width, residuals.data(), windowed);
+        write_subframe(writer, x, frames, width, plan, residuals.data());
+    }
+    writer.Flush();
+
+    return out.size();
+}
+
+bool LosslessDecoder::Decode(const char *encoded, size_t encoded_bytes, char *pcm, size_t pcm_bytes)
+{
+    if (!encoded || encoded_bytes < stream_header_bytes) {
+        return false;
+    }
+
+    auto header = reinterpret_cast<const uint8_t *>(encoded);
+    const auto format = static_cast<RecordingFormat_t>(header[0]);
+    const unsigned int channels = header[1];
+    const unsigned int channel_mode = header[2];
+    const size_t frames = header[4] | (header[5] << 8) | (header[6] << 16) | (static_cast<uint32_t>(header[7]) << 24);
+
+    const auto bits = sample_bits(format);
+    if (!bits || !channels || channel_mode > channel_mode_left_side || (channel_mode == channel_mode_left_side && channels != 2)) {
+        return false;
+    }
+    if (frames * channels * (bits / 8) != pcm_bytes || !pcm) {
+        return false;
+    }
+
+    samples.resize(frames * channels);
+    auto reader = BitReader(encoded + stream_header_bytes, encoded_bytes - stream_header_bytes);
+    for (unsigned int ch = 0; ch < channels; ++ch) {
+        const auto width = (ch == 1 && channel_mode == channel_mode_left_side) ? bits + 1 : bits;
+        if (!read_subframe(reader, samples.data() + ch * frames, frames, width)) {
+            return false;
+        }
+    }
+
+    if (channel_mode == channel_mode_left_side) { // right = left - side
+        const auto left = samples.data();
+        const auto side = left + frames;
+        for (size_t idx = 0; idx < frames; ++idx) {
+            side[idx] = left[idx] - side[idx];
+        }
+    }
+
+    write_samples(samples.data(), frames, channels, bits, pcm);
+    return true;
+}
@@ -0,0 +1,66 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#pragma once
+
+#include <vector>
+#include <cstring> // size_t
+#include <cstdint> // intxx_t
+
+#include "../../../audio_man.hpp"
+
+
+// FLAC-style lossless coding of one chunk of interleaved integer pcm
+// every channel is predicted independently (fixed polynomial or quantized LPC), stereo may be coded as left/side
+// residuals are stored with partitioned Rice codes, each chunk is self contained
+// the encoded stream records the pcm format and channels count so it can be decoded without any context
+
+class LosslessEncoder
+{
+private:
+    std::vector<int64_t> samples{}; // deinterleaved, one channel after another
+    std::vector<int64_t> residuals{};
+    std::vector<int64_t> side_samples{}; // left - right, stereo only
+    std::vector<double> windowed{};
+
+public:
+    // encodes 'bytes' of pcm into 'out' (resized as needed and reused across calls)
+    // returns the encoded size, or 0 if the format isn't supported (Float32) or the data doesn't form whole frames
+    size_t Encode(const char *pcm, size_t bytes, RecordingFormat_t format, unsigned int channels, std::vector<char> &out);
+};
+
+class LosslessDecoder
+{
+private:
+    std::vector<int64_t> samples{};
+
+public:
+    // decodes exactly 'pcm_bytes' of pcm into 'pcm'
+    // returns false if the stream is malformed or doesn't decode to 'pcm_bytes'
+    bool Decode(const char *encoded, size_t encoded_bytes, char *pcm, size_t pcm_bytes);
+};
@@ -0,0 +1,138 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#include <cstring> // std::memcpy
+
+#include "miniz/miniz.h"
+
+#include "../pcm_filter/pcm_filter.hpp"
+#include "mic_chunk.hpp"
+
+
+// decompresses straight into 'decompressed_data', tinfl keeps its state on the stack so nothing is allocated
+// returns false unless exactly 'original_size' bytes came out
+static bool decompress_gzip(const char *compressed_data, size_t compressed_data_size, char *decompressed_data, size_t original_size)
+{
+    auto decompressed_size = tinfl_decompress_mem_to_mem(
+        decompressed_data,
+        original_size,
+        compressed_data,
+        compressed_data_size,
+        TINFL_FLAG_PARSE_ZLIB_HEADER
+    );
+
+    return decompressed_size == original_size;
+}
+
+const char* ReadMicChunkHeader(const char *chunk, const char *chunks_end, MicChunkHeaderSerialized_t &header)
+{
+    const auto available = static_cast<size_t>(chunks_end - chunk);
+    uint32_t magic = 0;
+    if (available < sizeof(magic)) {
+        return nullptr;
+    }
+    std::memcpy(&magic, chunk, sizeof(magic)); // the stream has no alignment guarantees
+
+    size_t header_bytes = 0;
+    if (magic == mic_chunk_magic) {
+        if (available < sizeof(MicChunkHeaderSerialized_t)) {
+            return nullptr;
+        }
+
+        std::memcpy(&header, chunk, sizeof(header));
+        header_bytes = header.header_bytes;
+        if (header.version < mic_chunk_version || header_bytes < sizeof(MicChunkHeaderSerialized_t) || available < header_bytes) {
+            return nullptr;
+        }
+    } else {
+        auto legacy_header = MicChunkHeaderLegacySerialized_t{};
+        if (available < sizeof(legacy_header)) {
+            return nullptr;
+        }
+
+        std::memcpy(&legacy_header, chunk, sizeof(legacy_header));
+        header = MicChunkHeaderSerialized_t{};
+        header.version = 1;
+        header.header_bytes = sizeof(legacy_header);
+        header.original_bytes = legacy_header.original_bytes;
+        header.compressed_bytes = legacy_header.compressed_bytes;
+        header.codec = static_cast<uint16_t>(legacy_header.original_bytes == legacy_header.compressed_bytes ? RecordingCodec_t::None : RecordingCodec_t::Deflate);
+        header_bytes = sizeof(legacy_header);
+    }
+
+    auto payload = chunk + header_bytes;
+    if (static_cast<size_t>(chunks_end - payload) < header.compressed_bytes) {
+        return nullptr;
+    }
+
+    return payload;
+}
+
+size_t MicChunkFrameBytes(RecordingFormat_t format, unsigned int channels)
+{
+    switch (format) {
+    case RecordingFormat_t::Float32: return 4 * static_cast<size_t>(channels);
+    case RecordingFormat_t::Signed16: return 2 * static_cast<size_t>(channels);
+    case RecordingFormat_t::Signed24: return 3 * static_cast<size_t>(channels);
+    case RecordingFormat_t::Signed32: return 4 * static_cast<size_t>(channels);
+    case RecordingFormat_t::Unsigned8: return static_cast<size_t>(channels);
+
+    default: return 0;
+    }
+}
+
+void MicChunkDecoder::Decode(const MicChunkHeaderSerialized_t &header, const char *payload, char *out)
+{
+    bool ok = false;
+    switch (static_cast<RecordingCodec_t>(header.codec)) {
+    case RecordingCodec_t::Deflate:
+        if (header.filter) {
+            scratch.resize(header.original_bytes);
+            ok = decompress_gzip(payload, header.compressed_bytes, scratch.data(), header.original_bytes)
+                && PcmFilterRevert(header.filter, scratch.data(), header.original_bytes, out);
+        } else {
+            ok = decompress_gzip(payload, header.compressed_bytes, out, header.original_bytes);
+        }
+        break;
+
+    case RecordingCodec_t::Lossless:
+        ok = lossless_decoder.Decode(payload, header.compressed_bytes, out, header.original_bytes);
+        break;
+
+    default: // stored raw
+        ok = header.compressed_bytes == header.original_bytes;
+        if (ok) {
+            std::memcpy(out, payload, header.original_bytes);
+        }
+        break;
+    }
+
+    if (!ok) {
+        std::memset(out, 0, header.original_bytes);
+    }
+}
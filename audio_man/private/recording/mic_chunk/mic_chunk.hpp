@@ -0,0 +1,92 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#pragma once
+
+#include <vector>
+#include <cstring> // size_t
+#include <cstdint> // uintxx_t
+
+#include "../../../audio_man.hpp"
+#include "../lossless_codec/lossless_codec.hpp"
+
+
+// "AMCH" in a little-endian stream, the first bytes of a versioned chunk
+// legacy chunks start with 'original_bytes' instead, which is never anywhere near this big for a single period
+static constexpr uint32_t mic_chunk_magic = 0x48434D41;
+static constexpr uint16_t mic_chunk_version = 2;
+
+// every field is naturally aligned, the struct is written as is
+struct MicChunkHeaderSerialized_t
+{
+    uint32_t magic = mic_chunk_magic;
+    uint16_t version = mic_chunk_version;
+    uint16_t header_bytes = 0; // sizeof(MicChunkHeaderSerialized_t) when written, newer versions may append fields
+    uint32_t original_bytes{};
+    uint32_t compressed_bytes{};
+    uint16_t codec{}; // RecordingCodec_t
+    uint16_t filter{}; // PcmFilterId(), undone after decompressing
+    uint32_t format{}; // RecordingFormat_t
+    uint32_t sample_rate{};
+    uint16_t channels{};
+    uint16_t flags{}; // unused, 0
+    uint64_t seq{}; // see RecordingChunkInfo_t::seq
+    uint64_t frame_timestamp{}; // device frames captured before this chunk since the recording started, silence included
+    // compressed data array is appended here
+};
+static_assert(sizeof(MicChunkHeaderSerialized_t) == 48);
+
+// unversioned header written by older releases, a deflated chunk unless both sizes are equal (raw)
+struct MicChunkHeaderLegacySerialized_t
+{
+    uint32_t original_bytes{};
+    uint32_t compressed_bytes{};
+    // compressed data array is appended here
+};
+
+
+// reads the header of the chunk starting at 'chunk', legacy headers are converted to the current layout
+// returns its payload, or nullptr at the end of the stream or if the chunk is truncated
+const char* ReadMicChunkHeader(const char *chunk, const char *chunks_end, MicChunkHeaderSerialized_t &header);
+
+// bytes of one pcm frame, 0 if the format is unknown
+size_t MicChunkFrameBytes(RecordingFormat_t format, unsigned int channels);
+
+// decodes serialized chunks, keeps its scratch buffers across chunks
+// not thread safe, use one per thread
+class MicChunkDecoder
+{
+private:
+    LosslessDecoder lossless_decoder{};
+    std::vector<char> scratch{}; // chunks which were filtered before being deflated
+
+public:
+    // decodes exactly 'header.original_bytes' into 'out'
+    // a corrupted chunk comes out as zeros so the following ones keep their position
+    void Decode(const MicChunkHeaderSerialized_t &header, const char *payload, char *out);
+};
@@ -0,0 +1,209 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#include <algorithm>
+#include <cstring> // std::memcpy
+
+#include "mic_chunk_arena.hpp"
+
+
+RecordingView_t MicChunkArena::segments(const std::vector<char> &from, uint64_t pos, size_t bytes) const
+{
+    if (!bytes) {
+        return {};
+    }
+
+    const auto capacity = from.size();
+    const auto offset = static_cast<size_t>(pos % capacity);
+    const auto first_bytes = std::min(bytes, capacity - offset);
+
+    auto view = RecordingView_t{};
+    view.first = std::span<const char>(from.data() + offset, first_bytes);
+    view.second = std::span<const char>(from.data(), bytes - first_bytes);
+    return view;
+}
+
+void MicChunkArena::copy_in(uint64_t pos, const char *src, size_t bytes)
+{
+    const auto capacity = buffer.size();
+    const auto offset = static_cast<size_t>(pos % capacity);
+    const auto first_bytes = std::min(bytes, capacity - offset);
+
+    std::memcpy(buffer.data() + offset, src, first_bytes);
+    std::memcpy(buffer.data(), src + first_bytes, bytes - first_bytes);
+}
+
+MicChunkHeaderSerialized_t MicChunkArena::header_at(uint64_t pos) const
+{
+    // only chunks written by Push() live here, their headers can be trusted
+    const auto view = segments(buffer, pos, sizeof(MicChunkHeaderSerialized_t));
+
+    auto header = MicChunkHeaderSerialized_t{};
+    std::memcpy(&header, view.first.data(), view.first.size());
+    std::memcpy(reinterpret_cast<char *>(&header) + view.first.size(), view.second.data(), view.second.size());
+    return header;
+}
+
+void MicChunkArena::reserve(size_t bytes)
+{
+    const auto live_pos = pinned ? pin_pos : read_pos;
+    const auto live_bytes = static_cast<size_t>(write_pos - live_pos);
+    if (live_bytes + bytes <= buffer.size()) {
+        return;
+    }
+
+    // same positions in a bigger ring, the pinned bytes included
+    auto new_buffer = std::vector<char>(std::max({ min_capacity, buffer.size() * 2, live_bytes + bytes }));
+    if (live_bytes) {
+        const auto live = segments(buffer, live_pos, live_bytes);
+        std::swap(buffer, new_buffer);
+        copy_in(live_pos, live.first.data(), live.first.size());
+        copy_in(live_pos + live.first.size(), live.second.data(), live.second.size());
+    } else {
+        std::swap(buffer, new_buffer);
+    }
+
+    if (pinned) { // the view still points into it
+        retired_buffers.emplace_back(std::move(new_buffer));
+    }
+}
+
+void MicChunkArena::Push(const MicChunkHeaderSerialized_t &header, const char *compressed_data)
+{
+    reserve(sizeof(header) + header.compressed_bytes);
+
+    copy_in(write_pos, reinterpret_cast<const char *>(&header), sizeof(header));
+    copy_in(write_pos + sizeof(header), compressed_data, header.compressed_bytes);
+    write_pos += sizeof(header) + header.compressed_bytes;
+    chunks_count++;
+    original_bytes += header.original_bytes;
+    newest_frame_timestamp = header.frame_timestamp;
+}
+
+size_t MicChunkArena::WholeChunksBytes(size_t max_bytes) const
+{
+    auto end_pos = read_pos;
+    while (end_pos < write_pos) {
+        const auto chunk_bytes = sizeof(MicChunkHeaderSerialized_t) + header_at(end_pos).compressed_bytes;
+        if (end_pos - read_pos + chunk_bytes > max_bytes) {
+            break;
+        }
+
+        end_pos += chunk_bytes;
+    }
+
+    return static_cast<size_t>(end_pos - read_pos);
+}
+
+RecordingView_t MicChunkArena::View(size_t bytes) const
+{
+    return segments(buffer, read_pos, bytes);
+}
+
+void MicChunkArena::Consume(size_t bytes)
+{
+    const auto end_pos = read_pos + bytes;
+    while (read_pos < end_pos) {
+        const auto header = header_at(read_pos);
+        read_pos += sizeof(header) + header.compressed_bytes;
+        chunks_count--;
+        original_bytes -= header.original_bytes;
+    }
+
+    if (!chunks_count) {
+        Clear();
+    }
+}
+
+MicChunkHeaderSerialized_t MicChunkArena::OldestHeader() const
+{
+    return header_at(read_pos);
+}
+
+RecordingView_t MicChunkArena::OldestChunk() const
+{
+    return segments(buffer, read_pos, sizeof(MicChunkHeaderSerialized_t) + header_at(read_pos).compressed_bytes);
+}
+
+void MicChunkArena::Pin()
+{
+    pin_pos = read_pos;
+    pinned = true;
+}
+
+void MicChunkArena::Unpin()
+{
+    pinned = false;
+    retired_buffers.clear();
+    if (!chunks_count) {
+        Clear();
+    }
+}
+
+bool MicChunkArena::IsPinned() const
+{
+    return pinned;
+}
+
+void MicChunkArena::Clear()
+{
+    read_pos = write_pos;
+    chunks_count = 0;
+    original_bytes = 0;
+    newest_frame_timestamp = 0;
+
+    // a recording which was stalled for a while shouldn't hold on to its peak memory
+    if (!pinned && buffer.size() > shrink_capacity) {
+        buffer = std::vector<char>(min_capacity);
+    }
+}
+
+size_t MicChunkArena::SizeUnread() const
+{
+    return static_cast<size_t>(write_pos - read_pos);
+}
+
+size_t MicChunkArena::ChunksCount() const
+{
+    return chunks_count;
+}
+
+size_t MicChunkArena::OriginalBytes() const
+{
+    return original_bytes;
+}
+
+uint64_t MicChunkArena::OldestFrameTimestamp() const
+{
+    return chunks_count ? header_at(read_pos).frame_timestamp : 0;
+}
+
+uint64_t MicChunkArena::NewestFrameTimestamp() const
+{
+    return newest_frame_timestamp;
+}
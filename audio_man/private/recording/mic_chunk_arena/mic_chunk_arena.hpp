@@ -0,0 +1,92 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#pragma once
+
+#include <vector>
+#include <span>
+#include <cstring> // size_t
+#include <cstdint> // uintxx_t
+
+#include "../../../audio_man.hpp"
+#include "../mic_chunk/mic_chunk.hpp"
+
+
+// serialized chunks back to back in a growable byte ring, written once in wire format and read in place
+// positions only grow, the buffer offset of a position is taken modulo the capacity
+// a pinned view keeps its bytes untouched: the writer doesn't reuse them and a buffer replaced by growing is
+// retired instead of being freed until Unpin()
+// not thread safe
+class MicChunkArena
+{
+private:
+    static constexpr size_t min_capacity = 256 * 1024;
+    static constexpr size_t shrink_capacity = 16 * min_capacity; // an empty arena bigger than this shrinks back
+
+    std::vector<char> buffer{};
+    std::vector<std::vector<char>> retired_buffers{};
+    uint64_t read_pos{}; // oldest unread chunk
+    uint64_t write_pos{}; // end of the newest chunk
+    uint64_t pin_pos{}; // start of the pinned view, <= 'read_pos'
+    bool pinned{};
+    size_t chunks_count{};
+    size_t original_bytes{}; // of the unread chunks
+    uint64_t newest_frame_timestamp{};
+
+    RecordingView_t segments(const std::vector<char> &from, uint64_t pos, size_t bytes) const;
+    void copy_in(uint64_t pos, const char *src, size_t bytes);
+    MicChunkHeaderSerialized_t header_at(uint64_t pos) const;
+    void reserve(size_t bytes);
+
+public:
+    void Push(const MicChunkHeaderSerialized_t &header, const char *compressed_data);
+
+    // bytes of the oldest whole chunks which fit in 'max_bytes', 0 if even the oldest one doesn't
+    size_t WholeChunksBytes(size_t max_bytes) const;
+    // the oldest 'bytes', which must be whole chunks
+    RecordingView_t View(size_t bytes) const;
+    // forgets the oldest 'bytes', which must be whole chunks
+    void Consume(size_t bytes);
+    // the oldest chunk, invalidated by any non const call
+    MicChunkHeaderSerialized_t OldestHeader() const;
+    RecordingView_t OldestChunk() const;
+
+    // protects everything from the oldest unread chunk on, until Unpin()
+    void Pin();
+    void Unpin();
+    bool IsPinned() const;
+
+    void Clear(); // the pinned bytes stay untouched
+
+    size_t SizeUnread() const;
+    size_t ChunksCount() const;
+    size_t OriginalBytes() const; // decoded size of the unread chunks
+    // of the oldest and newest unread chunks, 0 if there are none
+    uint64_t OldestFrameTimestamp() const;
+    uint64_t NewestFrameTimestamp() const;
+};
@@ -0,0 +1,199 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#include <string>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <cstring> // std::memcpy
+#include <cstdint> // uintptr_t
+
+#include "mic_chunk_spill.hpp"
+
+
+// unique enough for several buffer managers of several processes sharing the temp directory
+static std::string temporary_spill_path(const void *owner)
+{
+    std::error_code ec{};
+    const auto temp_dir = std::filesystem::temp_directory_path(ec);
+    if (ec) {
+        return {};
+    }
+
+    const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    const auto file_name = "audio_man_spill_" + std::to_string(reinterpret_cast<uintptr_t>(owner)) + "_" + std::to_string(now) + ".tmp";
+    return (temp_dir / file_name).string();
+}
+
+
+
+
+bool MicChunkSpill::reserve(size_t bytes)
+{
+    if (write_offset + bytes <= mapped_file.Size()) {
+        return true;
+    }
+
+    // move the unread chunks back to the start, the consumed ones are dead space
+    if (read_offset) {
+        const auto unread_bytes = write_offset - read_offset;
+        auto data = mapped_file.WritableData();
+        std::memmove(data, data + read_offset, unread_bytes);
+        read_offset = 0;
+        write_offset = unread_bytes;
+        if (write_offset + bytes <= mapped_file.Size()) {
+            return true;
+        }
+    }
+
+    const auto new_size = std::max(write_offset + bytes, mapped_file.Size() * 2);
+    if (!mapped_file.Resize(new_size)) {
+        if (!IsOpen()) { // the unread chunks are gone with the mapping
+            Clear();
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool MicChunkSpill::Open(const char *path)
+{
+    Close();
+
+    const auto file_path = path && path[0] ? std::string(path) : temporary_spill_path(this);
+    return !file_path.empty() && mapped_file.CreateReadWrite(file_path.c_str(), min_file_bytes, true);
+}
+
+void MicChunkSpill::Close()
+{
+    mapped_file.Close();
+    Clear();
+}
+
+bool MicChunkSpill::IsOpen() const
+{
+    return mapped_file.IsOpen();
+}
+
+bool MicChunkSpill::Push(const MicChunkHeaderSerialized_t &header, const RecordingView_t &serialized_chunk)
+{
+    const auto chunk_bytes = serialized_chunk.Size();
+    if (!IsOpen() || !reserve(chunk_bytes)) {
+        return false;
+    }
+
+    auto chunk = mapped_file.WritableData() + write_offset;
+    std::memcpy(chunk, serialized_chunk.first.data(), serialized_chunk.first.size());
+    std::memcpy(chunk + serialized_chunk.first.size(), serialized_chunk.second.data(), serialized_chunk.second.size());
+    write_offset += chunk_bytes;
+    chunks_count++;
+    original_bytes += header.original_bytes;
+    newest_frame_timestamp = header.frame_timestamp;
+    return true;
+}
+
+std::span<const char> MicChunkSpill::View(size_t max_bytes) const
+{
+    if (!chunks_count) {
+        return {};
+    }
+
+    // only chunks written by Push() live here, their headers can be trusted
+    const auto data = mapped_file.Data();
+    auto end_offset = read_offset;
+    while (end_offset < write_offset) {
+        auto header = MicChunkHeaderSerialized_t{};
+        std::memcpy(&header, data + end_offset, sizeof(header));
+        const auto chunk_bytes = sizeof(header) + header.compressed_bytes;
+        if (end_offset - read_offset + chunk_bytes > max_bytes) {
+            break;
+        }
+
+        end_offset += chunk_bytes;
+    }
+
+    return std::span<const char>(data + read_offset, end_offset - read_offset);
+}
+
+void MicChunkSpill::Consume(size_t bytes)
+{
+    const auto data = mapped_file.Data();
+    const auto end_offset = read_offset + bytes;
+    while (read_offset < end_offset) {
+        auto header = MicChunkHeaderSerialized_t{};
+        std::memcpy(&header, data + read_offset, sizeof(header));
+        read_offset += sizeof(header) + header.compressed_bytes;
+        chunks_count--;
+        original_bytes -= header.original_bytes;
+    }
+
+    if (!chunks_count) { // start over at the beginning of the file, nothing to move
+        Clear();
+    }
+}
+
+void MicChunkSpill::Clear()
+{
+    read_offset = 0;
+    write_offset = 0;
+    chunks_count = 0;
+    original_bytes = 0;
+    newest_frame_timestamp = 0;
+}
+
+size_t MicChunkSpill::SizeUnread() const
+{
+    return write_offset - read_offset;
+}
+
+size_t MicChunkSpill::ChunksCount() const
+{
+    return chunks_count;
+}
+
+size_t MicChunkSpill::OriginalBytes() const
+{
+    return original_bytes;
+}
+
+uint64_t MicChunkSpill::OldestFrameTimestamp() const
+{
+    if (!chunks_count) {
+        return 0;
+    }
+
+    auto header = MicChunkHeaderSerialized_t{};
+    std::memcpy(&header, mapped_file.Data() + read_offset, sizeof(header));
+    return header.frame_timestamp;
+}
+
+uint64_t MicChunkSpill::NewestFrameTimestamp() const
+{
+    return newest_frame_timestamp;
+}
@@ -0,0 +1,78 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#pragma once
+
+#include <span>
+#include <cstring> // size_t
+#include <cstdint> // uintxx_t
+
+#include "../../../audio_man.hpp"
+#include "../../mapped_file/mapped_file.hpp"
+#include "../mic_chunk/mic_chunk.hpp"
+
+
+// fifo of serialized chunks kept in a memory mapped file instead of the heap
+// the file is temporary, it disappears once closed or if the process dies
+// not thread safe
+class MicChunkSpill
+{
+private:
+    static constexpr size_t min_file_bytes = 1024 * 1024;
+
+    MappedFile mapped_file{};
+    size_t read_offset{}; // oldest unread chunk
+    size_t write_offset{}; // end of the newest chunk
+    size_t chunks_count{};
+    size_t original_bytes{}; // of the unread chunks
+    uint64_t newest_frame_timestamp{};
+
+    bool reserve(size_t bytes);
+
+public:
+    // 'path' nullptr or empty picks a unique file in the temp directory
+    bool Open(const char *path);
+    void Close();
+    bool IsOpen() const;
+
+    // appends one serialized chunk after the newest one, false if the file couldn't grow
+    // the unread chunks are lost only if the file couldn't even be mapped back, see ChunksCount()
+    bool Push(const MicChunkHeaderSerialized_t &header, const RecordingView_t &serialized_chunk);
+    // the oldest whole chunks which fit in 'max_bytes', valid until the next Push() or Close()
+    std::span<const char> View(size_t max_bytes) const;
+    // forgets the oldest 'bytes', which must be whole chunks
+    void Consume(size_t bytes);
+    void Clear(); // keeps the file open
+
+    size_t SizeUnread() const;
+    size_t ChunksCount() const;
+    size_t OriginalBytes() const; // decoded size of the unread chunks
+    // of the oldest and newest unread chunks, 0 if there are none
+    uint64_t OldestFrameTimestamp() const;
+    uint64_t NewestFrameTimestamp() const;
+};
@@ -26,128 +26,94 @@ For more information, please refer to <https://unlicense.org>
 */
 
 #include "mic_gain.hpp"
+#include "mic_gain_kernels.hpp"
 #include <cmath>
 #include <cstdint> // intxx_t
+#include <cstring> // std::memmove
 
 
-std::vector<char> MicGainPcmF32::ApplyGain(const char *data, size_t count, float sound_gain)
+std::vector<char> IMicGain::ApplyGain(const char *data, size_t count, float sound_gain)
 {
     if (!data || !count) {
         return {};
     }
 
-    auto samples = reinterpret_cast<const float *>(data);
-    const auto samples_end = samples + (count / sizeof(float));
-    
     std::vector<char> result(count);
-    auto result_buff = reinterpret_cast<float *>(result.data());
-
-    for (; samples < samples_end; ++samples, ++result_buff) {
-        *result_buff = std::min(std::max(*samples * sound_gain, -1.0f), 1.0f);
-    }
-
+    ApplyGain(data, count, sound_gain, result.data());
     return result;
 }
 
-std::vector<char> MicGainPcmS16::ApplyGain(const char *data, size_t count, float sound_gain)
+
+
+void MicGainPcmF32::ApplyGain(const char *data, size_t count, float sound_gain, char *out)
 {
-    if (!data || !count) {
-        return {};
+    if (!data || !count || !out) {
+        return;
     }
 
-    auto samples = reinterpret_cast<const int16_t *>(data);
-    const auto samples_end = samples + (count / sizeof(int16_t));
-    
-    std::vector<char> result(count);
-    auto result_buff = reinterpret_cast<int16_t *>(result.data());
+    GetMicGainKernels().f32(
+        reinterpret_cast<const float *>(data),
+        reinterpret_cast<float *>(out),
+        count / sizeof(float),
+        sound_gain
+    );
+}
 
-    for (; samples < samples_end; ++samples, ++result_buff) {
-        *result_buff = static_cast<int16_t>(
-            std::min(std::max(*samples * sound_gain, -32768.0f), 32767.0f)
-        );
+void MicGainPcmS16::ApplyGain(const char *data, size_t count, float sound_gain, char *out)
+{
+    if (!data || !count || !out) {
+        return;
     }
 
-    return result;
+    GetMicGainKernels().s16(
+        reinterpret_cast<const int16_t *>(data),
+        reinterpret_cast<int16_t *>(out),
+        count / sizeof(int16_t),
+        sound_gain
+    );
 }
 
-std::vector<char> MicGainPcmS24::ApplyGain(const char *data, size_t count, float sound_gain)
+void MicGainPcmS24::ApplyGain(const char *data, size_t count, float sound_gain, char *out)
 {
-    if (!data || !count) {
-        return {};
+    if (!data || !count || !out) {
+        return;
     }
 
     // each sample is 3 bytes in 24-bit PCM
     if (count % 3 != 0) {
-        return std::vector<char>(data, data + count);
-    }
-
-    const auto data_end = data + count;
-    
-    std::vector<char> result(count);
-    auto result_buff = result.data();
-
-    for (; data < data_end; data += 3, result_buff += 3) {
-        int32_t sample =
-            static_cast<int32_t>( data[0] ) | 
-            (static_cast<int32_t>( data[1] ) << 8) | 
-            (static_cast<int32_t>( data[2] ) << 16);
-        
-        // sign-extend the 24-bit value to 32 bits
-        if (sample & 0x00800000L) { // notice the digit '8'
-            sample |= 0xFF000000L; // set the upper bits if the sign bit is set
+        if (out != data) {
+            std::memmove(out, data, count);
         }
-
-        sample = static_cast<int32_t>(
-            std::min(std::max(sample * static_cast<double>(sound_gain), -8388608.0), 8388607.0)
-        );
-        auto sample_buff = reinterpret_cast<char *>(&sample);
-
-        result_buff[0] = sample_buff[0];
-        result_buff[1] = sample_buff[1];
-        result_buff[2] = sample_buff[2];
+        return;
     }
 
-    return result;
+    GetMicGainKernels().s24(data, out, count / 3, sound_gain);
 }
 
-std::vector<char> MicGainPcmS32::ApplyGain(const char *data, size_t count, float sound_gain)
+void MicGainPcmS32::ApplyGain(const char *data, size_t count, float sound_gain, char *out)
 {
-    if (!data || !count) {
-        return {};
-    }
-
-    auto samples = reinterpret_cast<const int32_t *>(data);
-    const auto samples_end = samples + (count / sizeof(int32_t));
-    
-    std::vector<char> result(count);
-    auto result_buff = reinterpret_cast<int32_t *>(result.data());
-
-    for (; samples < samples_end; ++samples, ++result_buff) {
-        *result_buff = static_cast<int32_t>(
-            std::min(std::max(*samples * static_cast<double>(sound_gain), -2147483648.0), 2147483647.0)
-        );
+    if (!data || !count || !out) {
+        return;
     }
 
-    return result;
+    GetMicGainKernels().s32(
+        reinterpret_cast<const int32_t *>(data),
+        reinterpret_cast<int32_t *>(out),
+        count / sizeof(int32_t),
+        sound_gain
+    );
 }
 
-std::vector<char> MicGainPcmU8::ApplyGain(const char *data, size_t count, float sound_gain)
+void MicGainPcmU8::ApplyGain(const char *data, size_t count, float sound_gain, char *out)
 {
-    if (!data || !count) {
-        return {};
-    }
-
-    auto samples = reinterpret_cast<const uint8_t *>(data);
-    const auto samples_end = samples + (count / sizeof(uint8_t));
-    
-    std::vector<char> result(count);
-    auto result_buff = reinterpret_cast<uint8_t *>(result.data());
-
-    for (; samples < samples_end; ++samples, ++result_buff) {
-        *result_buff = static_cast<uint8_t>(
-            std::min(std::max(*samples * sound_gain, 0.0f), 255.0f)
-        );
+    if (!data || !count || !out) {
+        return;
     }
 
-    return result;
+    GetMicGainKernels().u8(
+        reinterpret_cast<const uint8_t *>(data),
+        reinterpret_cast<uint8_t *>(out),
+        count / sizeof(uint8_t),
+        sound_gain
+    );
 }
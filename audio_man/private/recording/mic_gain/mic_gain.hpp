@@ -33,35 +33,44 @@ For more information, please refer to <https://unlicense.org>
 class IMicGain
 {
 public:
-    virtual std::vector<char> ApplyGain(const char *data, size_t count, float sound_gain) = 0;
+    // writes the result to 'out' which must hold 'count' bytes, 'out' may be the same as 'data' (in-place)
+    // never allocates, safe to call on the audio thread
+    virtual void ApplyGain(const char *data, size_t count, float sound_gain, char *out) = 0;
+
+    std::vector<char> ApplyGain(const char *data, size_t count, float sound_gain);
 };
 
 class MicGainPcmF32 : public IMicGain
 {
 public:
-    std::vector<char> ApplyGain(const char *data, size_t count, float sound_gain);
+    using IMicGain::ApplyGain;
+    void ApplyGain(const char *data, size_t count, float sound_gain, char *out);
 };
 
 class MicGainPcmS16 : public IMicGain
 {
 public:
-    std::vector<char> ApplyGain(const char *data, size_t count, float sound_gain);
+    using IMicGain::ApplyGain;
+    void ApplyGain(const char *data, size_t count, float sound_gain, char *out);
 };
 
 class MicGainPcmS24 : public IMicGain
 {
 public:
-    std::vector<char> ApplyGain(const char *data, size_t count, float sound_gain);
+    using IMicGain::ApplyGain;
+    void ApplyGain(const char *data, size_t count, float sound_gain, char *out);
 };
 
 class MicGainPcmS32 : public IMicGain
 {
 public:
-    std::vector<char> ApplyGain(const char *data, size_t count, float sound_gain);
+    using IMicGain::ApplyGain;
+    void ApplyGain(const char *data, size_t count, float sound_gain, char *out);
 };
 
 class MicGainPcmU8 : public IMicGain
 {
 public:
-    std::vector<char> ApplyGain(const char *data, size_t count, float sound_gain);
+    using IMicGain::ApplyGain;
+    void ApplyGain(const char *data, size_t count, float sound_gain, char *out);
 };
@@ -0,0 +1,395 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#include "mic_gain_kernels.hpp"
+#include "../../cpu_features/cpu_features.hpp"
+#include "../pcm_s24/pcm_s24.hpp"
+#include <algorithm> // std::min std::max
+#include <cmath> // std::floor
+
+#if defined(AUDIO_MAN_X86)
+    #include <immintrin.h>
+#endif
+
+
+// *** scalar *** //
+// the reference behavior, also used for the remaining samples after the vectorized loops
+
+static void gain_f32_scalar(const float *in, float *out, size_t samples, float sound_gain)
+{
+    for (size_t idx = 0; idx < samples; ++idx) {
+        out[idx] = std::min(std::max(in[idx] * sound_gain, -1.0f), 1.0f);
+    }
+}
+
+static void gain_s16_scalar(const int16_t *in, int16_t *out, size_t samples, float sound_gain)
+{
+    for (size_t idx = 0; idx < samples; ++idx) {
+        out[idx] = static_cast<int16_t>(
+            std::min(std::max(in[idx] * sound_gain, -32768.0f), 32767.0f)
+        );
+    }
+}
+
+// 24-bit samples are unpacked in groups, gained in fixed-point (rounding toward -inf) then packed back
+// Q23 keeps the quantization error of the gain below half a 24-bit step at full scale
+static constexpr int s24_gain_frac_bits = 23;
+static constexpr size_t s24_group_samples = 256;
+
+// gains from 2^8 saturate nearly everything, and their fixed-point value wouldn't fit the 32-bit SIMD multiply
+// these rare ones are applied in double instead
+static constexpr double s24_max_fixed_gain = 256.0;
+
+static void s24_apply_gain_scalar(int32_t *samples, size_t count, float sound_gain)
+{
+    const auto gain = sound_gain > 0 ? static_cast<double>(sound_gain) : 0.0; // also NaN
+    if (gain >= s24_max_fixed_gain) {
+        for (size_t idx = 0; idx < count; ++idx) {
+            samples[idx] = static_cast<int32_t>(std::floor(std::min(std::max(samples[idx] * gain, -8388608.0), 8388607.0)));
+        }
+        return;
+    }
+
+    const auto gain_fixed = static_cast<int64_t>(gain * (1 << s24_gain_frac_bits) + 0.5);
+    for (size_t idx = 0; idx < count; ++idx) {
+        const auto gained = (samples[idx] * gain_fixed) >> s24_gain_frac_bits;
+        samples[idx] = static_cast<int32_t>(std::min(std::max(gained, static_cast<int64_t>(-8388608)), static_cast<int64_t>(8388607)));
+    }
+}
+
+static void gain_s24_scalar(const char *in, char *out, size_t samples, float sound_gain)
+{
+    int32_t group[s24_group_samples];
+    for (size_t idx = 0; idx < samples; idx += s24_group_samples) {
+        const auto count = std::min(s24_group_samples, samples - idx);
+        UnpackS24(in + idx * 3, group, count);
+        s24_apply_gain_scalar(group, count, sound_gain);
+        PackS24(group, out + idx * 3, count);
+    }
+}
+
+static void gain_s32_scalar(const int32_t *in, int32_t *out, size_t samples, float sound_gain)
+{
+    for (size_t idx = 0; idx < samples; ++idx) {
+        out[idx] = static_cast<int32_t>(
+            std::min(std::max(in[idx] * static_cast<double>(sound_gain), -2147483648.0), 2147483647.0)
+        );
+    }
+}
+
+static void gain_u8_scalar(const uint8_t *in, uint8_t *out, size_t samples, float sound_gain)
+{
+    for (size_t idx = 0; idx < samples; ++idx) {
+        out[idx] = static_cast<uint8_t>(
+            std::min(std::max(in[idx] * sound_gain, 0.0f), 255.0f)
+        );
+    }
+}
+// *** scalar *** //
+
+
+#if defined(AUDIO_MAN_X86)
+
+// notes for matching the scalar code:
+// - std::max(v, lo) is (v < lo) ? lo : v which is what _mm_max_ps(lo, v) does, also for NaN
+// - std::min(v, hi) is (hi < v) ? hi : v which is what _mm_min_ps(hi, v) does, also for NaN
+// - static_cast<intxx_t>() truncates toward zero, like the cvtt* instructions
+// - the clamped values always fit the destination type, so the saturating packs never kick in
+
+// *** SSE2 *** //
+AUDIO_MAN_TARGET_SSE2
+static void gain_f32_sse2(const float *in, float *out, size_t samples, float sound_gain)
+{
+    const auto gain = _mm_set1_ps(sound_gain);
+    const auto lo = _mm_set1_ps(-1.0f);
+    const auto hi = _mm_set1_ps(1.0f);
+
+    size_t idx = 0;
+    for (; idx + 4 <= samples; idx += 4) {
+        auto v = _mm_mul_ps(_mm_loadu_ps(in + idx), gain);
+        v = _mm_min_ps(hi, _mm_max_ps(lo, v));
+        _mm_storeu_ps(out + idx, v);
+    }
+
+    gain_f32_scalar(in + idx, out + idx, samples - idx, sound_gain);
+}
+
+AUDIO_MAN_TARGET_SSE2
+static void gain_s16_sse2(const int16_t *in, int16_t *out, size_t samples, float sound_gain)
+{
+    const auto gain = _mm_set1_ps(sound_gain);
+    const auto lo = _mm_set1_ps(-32768.0f);
+    const auto hi = _mm_set1_ps(32767.0f);
+
+    size_t idx = 0;
+    for (; idx + 8 <= samples; idx += 8) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + idx));
+        // sign-extend to int32 by placing each sample in the upper half then shifting it down
+        const auto v_lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const auto v_hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+        auto f_lo = _mm_mul_ps(_mm_cvtepi32_ps(v_lo), gain);
+        auto f_hi = _mm_mul_ps(_mm_cvtepi32_ps(v_hi), gain);
+        f_lo = _mm_min_ps(hi, _mm_max_ps(lo, f_lo));
+        f_hi = _mm_min_ps(hi, _mm_max_ps(lo, f_hi));
+
+        const auto r = _mm_packs_epi32(_mm_cvttps_epi32(f_lo), _mm_cvttps_epi32(f_hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + idx), r);
+    }
+
+    gain_s16_scalar(in + idx, out + idx, samples - idx, sound_gain);
+}
+
+AUDIO_MAN_TARGET_SSE2
+static void gain_s32_sse2(const int32_t *in, int32_t *out, size_t samples, float sound_gain)
+{
+    const auto gain = _mm_set1_pd(static_cast<double>(sound_gain));
+    const auto lo = _mm_set1_pd(-2147483648.0);
+    const auto hi = _mm_set1_pd(2147483647.0);
+
+    size_t idx = 0;
+    for (; idx + 4 <= samples; idx += 4) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + idx));
+
+        auto d_lo = _mm_mul_pd(_mm_cvtepi32_pd(v), gain);
+        auto d_hi = _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(v, _MM_SHUFFLE(3, 2, 3, 2))), gain);
+        d_lo = _mm_min_pd(hi, _mm_max_pd(lo, d_lo));
+        d_hi = _mm_min_pd(hi, _mm_max_pd(lo, d_hi));
+
+        const auto r = _mm_unpacklo_epi64(_mm_cvttpd_epi32(d_lo), _mm_cvttpd_epi32(d_hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + idx), r);
+    }
+
+    gain_s32_scalar(in + idx, out + idx, samples - idx, sound_gain);
+}
+
+AUDIO_MAN_TARGET_SSE2
+static void gain_u8_sse2(const uint8_t *in, uint8_t *out, size_t samples, float sound_gain)
+{
+    const auto gain = _mm_set1_ps(sound_gain);
+    const auto lo = _mm_set1_ps(0.0f);
+    const auto hi = _mm_set1_ps(255.0f);
+    const auto zero = _mm_setzero_si128();
+
+    size_t idx = 0;
+    for (; idx + 16 <= samples; idx += 16) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + idx));
+        const auto v16_lo = _mm_unpacklo_epi8(v, zero);
+        const auto v16_hi = _mm_unpackhi_epi8(v, zero);
+
+        __m128i v32[4] = {
+            _mm_unpacklo_epi16(v16_lo, zero),
+            _mm_unpackhi_epi16(v16_lo, zero),
+            _mm_unpacklo_epi16(v16_hi, zero),
+            _mm_unpackhi_epi16(v16_hi, zero),
+        };
+        for (auto &item : v32) {
+            auto f = _mm_mul_ps(_mm_cvtepi32_ps(item), gain);
+            f = _mm_min_ps(hi, _mm_max_ps(lo, f));
+            item = _mm_cvttps_epi32(f);
+        }
+
+        const auto r = _mm_packus_epi16(_mm_packs_epi32(v32[0], v32[1]), _mm_packs_epi32(v32[2], v32[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + idx), r);
+    }
+
+    gain_u8_scalar(in + idx, out + idx, samples - idx, sound_gain);
+}
+// *** SSE2 *** //
+
+
+// *** SSE4.1 *** //
+AUDIO_MAN_TARGET_SSE41
+static void s24_apply_gain_sse41(int32_t *samples, size_t count, float sound_gain)
+{
+    if (!(sound_gain > 0 && sound_gain < s24_max_fixed_gain)) {
+        s24_apply_gain_scalar(samples, count, sound_gain);
+        return;
+    }
+
+    // fits int32 and the shifted products fit the 32-bit lanes, since |sample| <= 2^23 and gain < 2^8
+    const auto gain_fixed = static_cast<int32_t>(static_cast<double>(sound_gain) * (1 << s24_gain_frac_bits) + 0.5);
+    const auto gain = _mm_set1_epi32(gain_fixed);
+    const auto lo = _mm_set1_epi32(-8388608);
+    const auto hi = _mm_set1_epi32(8388607);
+
+    size_t idx = 0;
+    for (; idx + 4 <= count; idx += 4) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + idx));
+
+        // signed 32x32 -> 64 products of the even lanes, then of the odd lanes moved down
+        const auto even = _mm_mul_epi32(v, gain);
+        const auto odd = _mm_mul_epi32(_mm_srli_epi64(v, 32), gain);
+
+        // the low 32 bits of a logical 64-bit shift match the arithmetic one,
+        // the odd products are shifted left so their bits land in the odd lanes
+        auto r = _mm_blend_epi16(
+            _mm_srli_epi64(even, s24_gain_frac_bits),
+            _mm_slli_epi64(odd, 32 - s24_gain_frac_bits),
+            0xCC
+        );
+        r = _mm_min_epi32(_mm_max_epi32(r, lo), hi);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(samples + idx), r);
+    }
+
+    s24_apply_gain_scalar(samples + idx, count - idx, sound_gain);
+}
+
+static void gain_s24_sse41(const char *in, char *out, size_t samples, float sound_gain)
+{
+    int32_t group[s24_group_samples];
+    for (size_t idx = 0; idx < samples; idx += s24_group_samples) {
+        const auto count = std::min(s24_group_samples, samples - idx);
+        UnpackS24(in + idx * 3, group, count);
+        s24_apply_gain_sse41(group, count, sound_gain);
+        PackS24(group, out + idx * 3, count);
+    }
+}
+// *** SSE4.1 *** //
+
+
+// *** AVX2 *** //
+AUDIO_MAN_TARGET_AVX2
+static void gain_f32_avx2(const float *in, float *out, size_t samples, float sound_gain)
+{
+    const auto gain = _mm256_set1_ps(sound_gain);
+    const auto lo = _mm256_set1_ps(-1.0f);
+    const auto hi = _mm256_set1_ps(1.0f);
+
+    size_t idx = 0;
+    for (; idx + 8 <= samples; idx += 8) {
+        auto v = _mm256_mul_ps(_mm256_loadu_ps(in + idx), gain);
+        v = _mm256_min_ps(hi, _mm256_max_ps(lo, v));
+        _mm256_storeu_ps(out + idx, v);
+    }
+
+    gain_f32_scalar(in + idx, out + idx, samples - idx, sound_gain);
+}
+
+AUDIO_MAN_TARGET_AVX2
+static void gain_s16_avx2(const int16_t *in, int16_t *out, size_t samples, float sound_gain)
+{
+    const auto gain = _mm256_set1_ps(sound_gain);
+    const auto lo = _mm256_set1_ps(-32768.0f);
+    const auto hi = _mm256_set1_ps(32767.0f);
+
+    size_t idx = 0;
+    for (; idx + 16 <= samples; idx += 16) {
+        const auto v_lo = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + idx)));
+        const auto v_hi = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + idx + 8)));
+
+        auto f_lo = _mm256_mul_ps(_mm256_cvtepi32_ps(v_lo), gain);
+        auto f_hi = _mm256_mul_ps(_mm256_cvtepi32_ps(v_hi), gain);
+        f_lo = _mm256_min_ps(hi, _mm256_max_ps(lo, f_lo));
+        f_hi = _mm256_min_ps(hi, _mm256_max_ps(lo, f_hi));
+
+        // packs works per 128-bit lane, restore the order of the 64-bit groups afterwards
+        auto r = _mm256_packs_epi32(_mm256_cvttps_epi32(f_lo), _mm256_cvttps_epi32(f_hi));
+        r = _mm256_permute4x64_epi64(r, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + idx), r);
+    }
+
+    gain_s16_scalar(in + idx, out + idx, samples - idx, sound_gain);
+}
+
+AUDIO_MAN_TARGET_AVX2
+static void gain_s32_avx2(const int32_t *in, int32_t *out, size_t samples, float sound_gain)
+{
+    const auto gain = _mm256_set1_pd(static_cast<double>(sound_gain));
+    const auto lo = _mm256_set1_pd(-2147483648.0);
+    const auto hi = _mm256_set1_pd(2147483647.0);
+
+    size_t idx = 0;
+    for (; idx + 8 <= samples; idx += 8) {
+        auto d_lo = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + idx))), gain);
+        auto d_hi = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + idx + 4))), gain);
+        d_lo = _mm256_min_pd(hi, _mm256_max_pd(lo, d_lo));
+        d_hi = _mm256_min_pd(hi, _mm256_max_pd(lo, d_hi));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + idx), _mm256_cvttpd_epi32(d_lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + idx + 4), _mm256_cvttpd_epi32(d_hi));
+    }
+
+    gain_s32_scalar(in + idx, out + idx, samples - idx, sound_gain);
+}
+
+AUDIO_MAN_TARGET_AVX2
+static void gain_u8_avx2(const uint8_t *in, uint8_t *out, size_t samples, float sound_gain)
+{
+    const auto gain = _mm256_set1_ps(sound_gain);
+    const auto lo = _mm256_set1_ps(0.0f);
+    const auto hi = _mm256_set1_ps(255.0f);
+    const auto order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    size_t idx = 0;
+    for (; idx + 32 <= samples; idx += 32) {
+        __m256i v32[4]{};
+        for (int part = 0; part < 4; ++part) {
+            const auto v8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + idx + part * 8));
+            auto f = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v8)), gain);
+            f = _mm256_min_ps(hi, _mm256_max_ps(lo, f));
+            v32[part] = _mm256_cvttps_epi32(f);
+        }
+
+        // packs/packus work per 128-bit lane, restore the order of the 32-bit groups afterwards
+        auto r = _mm256_packus_epi16(_mm256_packs_epi32(v32[0], v32[1]), _mm256_packs_epi32(v32[2], v32[3]));
+        r = _mm256_permutevar8x32_epi32(r, order);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + idx), r);
+    }
+
+    gain_u8_scalar(in + idx, out + idx, samples - idx, sound_gain);
+}
+// *** AVX2 *** //
+
+#endif // AUDIO_MAN_X86
+
+
+static MicGainKernels_t select_kernels()
+{
+    MicGainKernels_t kernels{ gain_f32_scalar, gain_s16_scalar, gain_s24_scalar, gain_s32_scalar, gain_u8_scalar };
+
+#if defined(AUDIO_MAN_X86)
+    const auto &features = GetCpuFeatures();
+    if (features.avx2) {
+        kernels = { gain_f32_avx2, gain_s16_avx2, gain_s24_sse41, gain_s32_avx2, gain_u8_avx2 };
+    } else if (features.sse2) {
+        kernels = { gain_f32_sse2, gain_s16_sse2, gain_s24_scalar, gain_s32_sse2, gain_u8_sse2 };
+        if (features.sse41) {
+            kernels.s24 = gain_s24_sse41;
+        }
+    }
+#endif
+
+    return kernels;
+}
+
+const MicGainKernels_t& GetMicGainKernels()
+{
+    static const MicGainKernels_t kernels = select_kernels();
+    return kernels;
+}
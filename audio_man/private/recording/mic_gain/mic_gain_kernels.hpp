@@ -0,0 +1,48 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#pragma once
+
+#include <cstring> // size_t
+#include <cstdint> // intxx_t
+
+
+// bulk gain kernels, 'in' and 'out' may be the same buffer (in-place)
+// every implementation saturates exactly like the scalar one, so the output is bit-identical on every cpu
+// 24-bit samples use integer Q23 fixed-point gain rounded toward -inf (gains from 256 in double), the others multiply in float (double for 32-bit)
+// so 24-bit output can differ by 1 LSB from the previous double math
+struct MicGainKernels_t {
+    void (*f32)(const float *in, float *out, size_t samples, float sound_gain);
+    void (*s16)(const int16_t *in, int16_t *out, size_t samples, float sound_gain);
+    void (*s24)(const char *in, char *out, size_t samples, float sound_gain); // 'samples' of 3 bytes each
+    void (*s32)(const int32_t *in, int32_t *out, size_t samples, float sound_gain);
+    void (*u8)(const uint8_t *in, uint8_t *out, size_t samples, float sound_gain);
+};
+
+// the fastest kernels supported by this cpu, selected once on first use
+const MicGainKernels_t& GetMicGainKernels();
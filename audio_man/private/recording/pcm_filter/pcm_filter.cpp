@@ -0,0 +1,168 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#include "pcm_filter.hpp"
+
+
+// filter id layout: [channels 8 bits][sample bytes 4 bits][filter 4 bits]
+static constexpr unsigned int filter_bits = 4;
+static constexpr unsigned int sample_bytes_bits = 4;
+
+struct PcmFilterLayout_t
+{
+    RecordingFilter_t filter{};
+    unsigned int sample_bytes{};
+    unsigned int channels{};
+};
+
+static bool unpack_filter_id(uint16_t filter_id, PcmFilterLayout_t &layout)
+{
+    layout.filter = static_cast<RecordingFilter_t>(filter_id & ((1u << filter_bits) - 1));
+    layout.sample_bytes = (filter_id >> filter_bits) & ((1u << sample_bytes_bits) - 1);
+    layout.channels = filter_id >> (filter_bits + sample_bytes_bits);
+
+    return layout.filter == RecordingFilter_t::DeltaBytePlanes
+        && layout.sample_bytes >= 1 && layout.sample_bytes <= 4
+        && layout.channels;
+}
+
+template<unsigned int SampleBytes>
+static uint32_t load_sample(const uint8_t *src)
+{
+    uint32_t value = 0;
+    for (unsigned int idx = 0; idx < SampleBytes; ++idx) {
+        value |= static_cast<uint32_t>(src[idx]) << (idx * 8);
+    }
+    return value;
+}
+
+// byte 'plane' of channel 'ch' lives at out[(plane * channels + ch) * frames + frame]
+template<unsigned int SampleBytes>
+static void apply_delta_planes(const uint8_t *pcm, size_t frames, unsigned int channels, uint8_t *out)
+{
+    for (unsigned int ch = 0; ch < channels; ++ch) {
+        uint32_t prev = 0;
+        auto src = pcm + ch * SampleBytes;
+        for (size_t frame = 0; frame < frames; ++frame, src += channels * SampleBytes) {
+            const auto value = load_sample<SampleBytes>(src);
+            const auto delta = value - prev;
+            prev = value;
+            for (unsigned int plane = 0; plane < SampleBytes; ++plane) {
+                out[(plane * channels + ch) * frames + frame] = static_cast<uint8_t>(delta >> (plane * 8));
+            }
+        }
+    }
+}
+
+template<unsigned int SampleBytes>
+static void revert_delta_planes(const uint8_t *filtered, size_t frames, unsigned int channels, uint8_t *out)
+{
+    for (unsigned int ch = 0; ch < channels; ++ch) {
+        uint32_t prev = 0;
+        auto dst = out + ch * SampleBytes;
+        for (size_t frame = 0; frame < frames; ++frame, dst += channels * SampleBytes) {
+            uint32_t delta = 0;
+            for (unsigned int plane = 0; plane < SampleBytes; ++plane) {
+                delta |= static_cast<uint32_t>(filtered[(plane * channels + ch) * frames + frame]) << (plane * 8);
+            }
+            prev += delta; // only the low SampleBytes bytes matter, the wrap is the same
+            for (unsigned int idx = 0; idx < SampleBytes; ++idx) {
+                dst[idx] = static_cast<uint8_t>(prev >> (idx * 8));
+            }
+        }
+    }
+}
+
+uint16_t PcmFilterId(RecordingFilter_t filter, RecordingFormat_t format, unsigned int channels)
+{
+    if (filter != RecordingFilter_t::DeltaBytePlanes || !channels || channels > UINT8_MAX) {
+        return 0;
+    }
+
+    unsigned int sample_bytes = 0;
+    switch (format) {
+    case RecordingFormat_t::Unsigned8: sample_bytes = 1; break;
+    case RecordingFormat_t::Signed16: sample_bytes = 2; break;
+    case RecordingFormat_t::Signed24: sample_bytes = 3; break;
+    case RecordingFormat_t::Signed32: sample_bytes = 4; break;
+
+    default: return 0; // deltas of float bit patterns don't mean much
+    }
+
+    return static_cast<uint16_t>(static_cast<unsigned int>(filter) | (sample_bytes << filter_bits) | (channels << (filter_bits + sample_bytes_bits)));
+}
+
+bool PcmFilterApply(uint16_t filter_id, const char *pcm, size_t bytes, char *out)
+{
+    auto layout = PcmFilterLayout_t{};
+    if (!unpack_filter_id(filter_id, layout) || !pcm || !out) {
+        return false;
+    }
+
+    const auto frame_bytes = static_cast<size_t>(layout.sample_bytes) * layout.channels;
+    if (bytes % frame_bytes) {
+        return false;
+    }
+
+    const auto frames = bytes / frame_bytes;
+    auto src = reinterpret_cast<const uint8_t *>(pcm);
+    auto dst = reinterpret_cast<uint8_t *>(out);
+    switch (layout.sample_bytes) {
+    case 1: apply_delta_planes<1>(src, frames, layout.channels, dst); break;
+    case 2: apply_delta_planes<2>(src, frames, layout.channels, dst); break;
+    case 3: apply_delta_planes<3>(src, frames, layout.channels, dst); break;
+    case 4: apply_delta_planes<4>(src, frames, layout.channels, dst); break;
+    }
+
+    return true;
+}
+
+bool PcmFilterRevert(uint16_t filter_id, const char *filtered, size_t bytes, char *out)
+{
+    auto layout = PcmFilterLayout_t{};
+    if (!unpack_filter_id(filter_id, layout) || !filtered || !out) {
+        return false;
+    }
+
+    const auto frame_bytes = static_cast<size_t>(layout.sample_bytes) * layout.channels;
+    if (bytes % frame_bytes) {
+        return false;
+    }
+
+    const auto frames = bytes / frame_bytes;
+    auto src = reinterpret_cast<const uint8_t *>(filtered);
+    auto dst = reinterpret_cast<uint8_t *>(out);
+    switch (layout.sample_bytes) {
+    case 1: revert_delta_planes<1>(src, frames, layout.channels, dst); break;
+    case 2: revert_delta_planes<2>(src, frames, layout.channels, dst); break;
+    case 3: revert_delta_planes<3>(src, frames, layout.channels, dst); break;
+    case 4: revert_delta_planes<4>(src, frames, layout.channels, dst); break;
+    }
+
+    return true;
+}
@@ -0,0 +1,50 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#pragma once
+
+#include <cstring> // size_t
+#include <cstdint> // uintxx_t
+
+#include "../../../audio_man.hpp"
+
+
+// reversible reordering of interleaved integer pcm ahead of deflate
+// channels are deinterleaved, every sample is replaced by its difference from the previous sample of the same channel
+// (wrapping in the sample width) and the differences are split into byte planes, all the low bytes first
+// slowly changing audio then turns into long runs of near-zero bytes in the upper planes
+// the output has the same size as the input
+
+// packs the parameters needed to undo the filter, 0 means no filtering
+// returns 0 for layouts the filter doesn't apply to (Float32, more than 255 channels)
+uint16_t PcmFilterId(RecordingFilter_t filter, RecordingFormat_t format, unsigned int channels);
+
+// 'out' must hold 'bytes' and can't overlap 'pcm'
+// returns false if 'filter_id' is 0/malformed or 'bytes' doesn't form whole frames
+bool PcmFilterApply(uint16_t filter_id, const char *pcm, size_t bytes, char *out);
+bool PcmFilterRevert(uint16_t filter_id, const char *filtered, size_t bytes, char *out);
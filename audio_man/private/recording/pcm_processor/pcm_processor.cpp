@@ -0,0 +1,157 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#include "pcm_processor.hpp"
+#include "../mic_gain/mic_gain_kernels.hpp"
+#include "../silence_filter/silence_filter_kernels.hpp"
+#include <algorithm> // std::min
+#include <cstdint> // intxx_t
+
+
+// samples processed per step, small enough for the gained block to still be in L1 when it's checked for silence
+static constexpr size_t block_samples = 256;
+
+
+template<RecordingFormat_t Format>
+struct PcmFormatTraits;
+
+template<>
+struct PcmFormatTraits<RecordingFormat_t::Float32>
+{
+    using sample_t = float;
+    static constexpr size_t sample_bytes = sizeof(float);
+
+    static auto gain_kernel() { return GetMicGainKernels().f32; }
+    static auto silence_kernel() { return GetMicSilenceKernels().f32; }
+    static float threshold(float sound_threshold) { return sound_threshold; }
+};
+
+template<>
+struct PcmFormatTraits<RecordingFormat_t::Signed16>
+{
+    using sample_t = int16_t;
+    static constexpr size_t sample_bytes = sizeof(int16_t);
+
+    static auto gain_kernel() { return GetMicGainKernels().s16; }
+    static auto silence_kernel() { return GetMicSilenceKernels().s16; }
+    static int32_t threshold(float sound_threshold) { return MicSilenceThresholdS16(sound_threshold); }
+};
+
+template<>
+struct PcmFormatTraits<RecordingFormat_t::Signed24>
+{
+    using sample_t = char; // packed, 3 bytes per sample
+    static constexpr size_t sample_bytes = 3;
+
+    static auto gain_kernel() { return GetMicGainKernels().s24; }
+    static auto silence_kernel() { return GetMicSilenceKernels().s24; }
+    static int32_t threshold(float sound_threshold) { return MicSilenceThresholdS24(sound_threshold); }
+};
+
+template<>
+struct PcmFormatTraits<RecordingFormat_t::Signed32>
+{
+    using sample_t = int32_t;
+    static constexpr size_t sample_bytes = sizeof(int32_t);
+
+    static auto gain_kernel() { return GetMicGainKernels().s32; }
+    static auto silence_kernel() { return GetMicSilenceKernels().s32; }
+    static int32_t threshold(float sound_threshold) { return MicSilenceThresholdS32(sound_threshold); }
+};
+
+template<>
+struct PcmFormatTraits<RecordingFormat_t::Unsigned8>
+{
+    using sample_t = uint8_t;
+    static constexpr size_t sample_bytes = sizeof(uint8_t);
+
+    static auto gain_kernel() { return GetMicGainKernels().u8; }
+    static auto silence_kernel() { return GetMicSilenceKernels().u8; }
+    static int32_t threshold(float sound_threshold) { return MicSilenceThresholdU8(sound_threshold); }
+};
+
+
+template<RecordingFormat_t Format>
+static bool process_pcm(const char *in, char *out, size_t count, float sound_gain, float sound_threshold)
+{
+    using Traits = PcmFormatTraits<Format>;
+    using sample_t = typename Traits::sample_t;
+
+    if (!in || !count || !out) {
+        return true;
+    }
+
+    if constexpr (Traits::sample_bytes == 3) {
+        if (count % 3 != 0) { // invalid data size, keep it as is
+            if (out != in) {
+                std::memmove(out, in, count);
+            }
+            return false;
+        }
+    }
+
+    // the kernels tables are resolved once, these are plain loads
+    const auto gain_kernel = Traits::gain_kernel();
+    const auto silence_kernel = Traits::silence_kernel();
+    const auto threshold = Traits::threshold(sound_threshold);
+
+    const auto samples = count / Traits::sample_bytes;
+    auto samples_in = reinterpret_cast<const sample_t *>(in);
+    auto samples_out = reinterpret_cast<sample_t *>(out);
+    constexpr size_t block_elements = block_samples * (Traits::sample_bytes == 3 ? 3 : 1);
+
+    bool is_silence = true;
+    for (size_t idx = 0; idx < samples; idx += block_samples) {
+        const auto cur_samples = std::min(block_samples, samples - idx);
+        gain_kernel(samples_in, samples_out, cur_samples, sound_gain);
+        
+        // once a loud sample was found only the gain is left
+        if (is_silence) {
+            is_silence = silence_kernel(samples_out, cur_samples, threshold);
+        }
+
+        samples_in += block_elements;
+        samples_out += block_elements;
+    }
+
+    return is_silence;
+}
+
+
+PcmProcessorFn GetPcmProcessor(RecordingFormat_t format)
+{
+    switch (format) {
+    case RecordingFormat_t::Float32: return process_pcm<RecordingFormat_t::Float32>;
+    case RecordingFormat_t::Signed16: return process_pcm<RecordingFormat_t::Signed16>;
+    case RecordingFormat_t::Signed24: return process_pcm<RecordingFormat_t::Signed24>;
+    case RecordingFormat_t::Signed32: return process_pcm<RecordingFormat_t::Signed32>;
+    case RecordingFormat_t::Unsigned8: return process_pcm<RecordingFormat_t::Unsigned8>;
+    
+    default: return nullptr;
+    }
+}
@@ -0,0 +1,43 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#pragma once
+
+#include <cstring> // size_t
+
+#include "../../../audio_man.hpp"
+
+
+// applies the gain to 'count' bytes of 'in' writing them to 'out', and checks the result for silence in the same pass
+// 'out' must hold 'count' bytes and may be the same as 'in' (in-place)
+// returns true if the gained data is silence
+// never allocates, safe to call on the audio thread
+using PcmProcessorFn = bool (*)(const char *in, char *out, size_t count, float sound_gain, float sound_threshold);
+
+// resolved once when the recording starts, nullptr for unknown formats
+PcmProcessorFn GetPcmProcessor(RecordingFormat_t format);
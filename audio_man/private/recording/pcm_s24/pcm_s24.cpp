@@ -0,0 +1,156 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#include "pcm_s24.hpp"
+#include "../../cpu_features/cpu_features.hpp"
+
+#if defined(AUDIO_MAN_X86)
+    #include <immintrin.h>
+#endif
+
+
+using unpack_fn = void (*)(const char *packed, int32_t *samples, size_t count);
+using pack_fn = void (*)(const int32_t *samples, char *packed, size_t count);
+
+
+// *** scalar *** //
+static void unpack_s24_scalar(const char *packed, int32_t *samples, size_t count)
+{
+    auto bytes = reinterpret_cast<const uint8_t *>(packed);
+    for (size_t idx = 0; idx < count; ++idx, bytes += 3) {
+        // place the 24 bits at the top then shift back down, this sign-extends the sample
+        samples[idx] = static_cast<int32_t>(
+            (static_cast<uint32_t>(bytes[0]) << 8) |
+            (static_cast<uint32_t>(bytes[1]) << 16) |
+            (static_cast<uint32_t>(bytes[2]) << 24)
+        ) >> 8;
+    }
+}
+
+static void pack_s24_scalar(const int32_t *samples, char *packed, size_t count)
+{
+    auto bytes = reinterpret_cast<uint8_t *>(packed);
+    for (size_t idx = 0; idx < count; ++idx, bytes += 3) {
+        const auto sample = static_cast<uint32_t>(samples[idx]);
+        bytes[0] = static_cast<uint8_t>(sample);
+        bytes[1] = static_cast<uint8_t>(sample >> 8);
+        bytes[2] = static_cast<uint8_t>(sample >> 16);
+    }
+}
+// *** scalar *** //
+
+
+#if defined(AUDIO_MAN_X86)
+
+// *** SSSE3 *** //
+AUDIO_MAN_TARGET_SSSE3
+static void unpack_s24_ssse3(const char *packed, int32_t *samples, size_t count)
+{
+    // 4 packed samples (12 bytes) into the upper 3 bytes of 4 int32 lanes, the lowest byte is zeroed (-1)
+    const auto unpack = _mm_setr_epi8(
+        -1, 0, 1, 2,
+        -1, 3, 4, 5,
+        -1, 6, 7, 8,
+        -1, 9, 10, 11
+    );
+
+    size_t idx = 0;
+    // every load reads 16 bytes but consumes 12, stop while the next load still fits
+    for (; (idx + 4) * 3 + 4 <= count * 3; idx += 4) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(packed + idx * 3));
+        v = _mm_srai_epi32(_mm_shuffle_epi8(v, unpack), 8); // sign-extend
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(samples + idx), v);
+    }
+
+    unpack_s24_scalar(packed + idx * 3, samples + idx, count - idx);
+}
+
+AUDIO_MAN_TARGET_SSSE3
+static void pack_s24_ssse3(const int32_t *samples, char *packed, size_t count)
+{
+    // the lower 3 bytes of 4 int32 lanes into 12 contiguous bytes, the last 4 bytes are unused
+    const auto pack = _mm_setr_epi8(
+        0, 1, 2,
+        4, 5, 6,
+        8, 9, 10,
+        12, 13, 14,
+        -1, -1, -1, -1
+    );
+
+    size_t idx = 0;
+    for (; idx + 4 <= count; idx += 4) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + idx));
+        v = _mm_shuffle_epi8(v, pack);
+        
+        // store exactly 12 bytes, writing 16 would clobber the next samples when packing in place
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(packed + idx * 3), v);
+        const auto last_4_bytes = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+        std::memcpy(packed + idx * 3 + 8, &last_4_bytes, 4);
+    }
+
+    pack_s24_scalar(samples + idx, packed + idx * 3, count - idx);
+}
+// *** SSSE3 *** //
+
+#endif // AUDIO_MAN_X86
+
+
+struct S24Kernels_t {
+    unpack_fn unpack;
+    pack_fn pack;
+};
+
+static S24Kernels_t select_kernels()
+{
+    S24Kernels_t kernels{ unpack_s24_scalar, pack_s24_scalar };
+
+#if defined(AUDIO_MAN_X86)
+    if (GetCpuFeatures().ssse3) {
+        kernels = { unpack_s24_ssse3, pack_s24_ssse3 };
+    }
+#endif
+
+    return kernels;
+}
+
+static const S24Kernels_t& get_kernels()
+{
+    static const S24Kernels_t kernels = select_kernels();
+    return kernels;
+}
+
+
+void UnpackS24(const char *packed, int32_t *samples, size_t count)
+{
+    get_kernels().unpack(packed, samples, count);
+}
+
+void PackS24(const int32_t *samples, char *packed, size_t count)
+{
+    get_kernels().pack(samples, packed, count);
+}
@@ -27,154 +27,688 @@ For more information, please refer to <https://unlicense.org>
 
 #include <utility>
 #include <memory>
-#include <numeric>
-#include <unordered_map>
+#include <algorithm>
+#include <cstring> // std::memcpy
 
 #include "miniz/miniz.h"
 
-#include "silence_filter/silence_filter.hpp"
-#include "mic_gain/mic_gain.hpp"
 #include "recording.hpp"
 
 
-static const std::unordered_map<RecordingFormat_t, std::unique_ptr<IMicSilenceFilter>> silence_filters = [] {
-    std::unordered_map<RecordingFormat_t, std::unique_ptr<IMicSilenceFilter>> filters{};
+// compresses into 'compressed_data' which is reused across calls to avoid reallocating it for every chunk
+// 'compressor' is reset and reused too, mz_compress2() would allocate a new one for every chunk
+// returns the compressed size, or 0 on failure
+static size_t compress_gzip(tdefl_compressor *compressor, int level, const char *data, uint32_t bytes, std::vector<char> &compressed_data)
+{
+    auto max_compressed_bytes = mz_compressBound(bytes);
+    if (compressed_data.size() < max_compressed_bytes) {
+        compressed_data.resize(max_compressed_bytes);
+    }
+
+    // zlib stream, same output format as mz_compress2() so mz_uncompress() keeps working
+    const auto flags = static_cast<int>(tdefl_create_comp_flags_from_zip_params(level, MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY));
+    if (tdefl_init(compressor, nullptr, nullptr, flags) != TDEFL_STATUS_OKAY) {
+        return 0;
+    }
+
+    size_t in_bytes = bytes;
+    size_t compressed_bytes = max_compressed_bytes;
+    auto status = tdefl_compress(compressor, data, &in_bytes, compressed_data.data(), &compressed_bytes, TDEFL_FINISH);
+    if (status != TDEFL_STATUS_DONE) {
+        return 0;
+    }
+
+    return compressed_bytes;
+}
+
+// bytes of the whole chunks among the first 'max_bytes' of a view written by this buffer manager
+static size_t whole_chunks_bytes(const RecordingView_t &view, size_t max_bytes)
+{
+    max_bytes = std::min(max_bytes, view.Size());
 
-    filters.try_emplace( RecordingFormat_t::Float32,   std::move( std::make_unique<MicSilenceFilterPcmF32>() ) );
-    filters.try_emplace( RecordingFormat_t::Signed16,  std::move( std::make_unique<MicSilenceFilterPcmS16>() ) );
-    filters.try_emplace( RecordingFormat_t::Signed24,  std::move( std::make_unique<MicSilenceFilterPcmS24>() ) );
-    filters.try_emplace( RecordingFormat_t::Signed32,  std::move( std::make_unique<MicSilenceFilterPcmS32>() ) );
-    filters.try_emplace( RecordingFormat_t::Unsigned8, std::move( std::make_unique<MicSilenceFilterPcmU8>()  ) );
+    size_t bytes = 0;
+    while (bytes + sizeof(MicChunkHeaderSerialized_t) <= max_bytes) {
+        // the header may be split between both spans
+        auto header = MicChunkHeaderSerialized_t{};
+        for (size_t i = 0; i < sizeof(header); i++) {
+            const auto pos = bytes + i;
+            reinterpret_cast<char *>(&header)[i] = pos < view.first.size() ? view.first[pos] : view.second[pos - view.first.size()];
+        }
 
-    return filters;
-}();
+        const auto chunk_bytes = sizeof(header) + header.compressed_bytes;
+        if (bytes + chunk_bytes > max_bytes) {
+            break;
+        }
+        bytes += chunk_bytes;
+    }
 
-static const std::unordered_map<RecordingFormat_t, std::unique_ptr<IMicGain>> gain_filters = [] {
-    std::unordered_map<RecordingFormat_t, std::unique_ptr<IMicGain>> filters{};
+    return bytes;
+}
 
-    filters.try_emplace( RecordingFormat_t::Float32,   std::move( std::make_unique<MicGainPcmF32>() ) );
-    filters.try_emplace( RecordingFormat_t::Signed16,  std::move( std::make_unique<MicGainPcmS16>() ) );
-    filters.try_emplace( RecordingFormat_t::Signed24,  std::move( std::make_unique<MicGainPcmS24>() ) );
-    filters.try_emplace( RecordingFormat_t::Signed32,  std::move( std::make_unique<MicGainPcmS32>() ) );
-    filters.try_emplace( RecordingFormat_t::Unsigned8, std::move( std::make_unique<MicGainPcmU8>()  ) );
 
-    return filters;
-}();
 
 
-static std::vector<char> compress_gzip(const char *data, uint32_t bytes)
+void RecordingBufferMan::compression_worker_loop()
 {
-    auto max_compressed_bytes = mz_compressBound(bytes);
-    std::vector<char> compressed_data(max_compressed_bytes);
-
-    auto compressed_bytes = static_cast<mz_ulong>(max_compressed_bytes);
-    auto status = mz_compress2(
-        reinterpret_cast<unsigned char *>(compressed_data.data()),
-        &compressed_bytes,
-        reinterpret_cast<const unsigned char*>(data),
-        bytes,
-        MZ_BEST_SPEED
+    while (!worker_stop_requested.load(std::memory_order_acquire)) {
+        const auto seen_wakeup = worker_wakeup.load(std::memory_order_acquire);
+        compress_pending_chunks();
+        worker_wakeup.wait(seen_wakeup, std::memory_order_acquire);
+    }
+
+    // whatever the audio thread managed to push before it was stopped
+    compress_pending_chunks();
+}
+
+const char* RecordingBufferMan::compress_chunk(const MicRawChunk_t &raw_chunk, MicChunkHeaderSerialized_t &header)
+{
+    const auto bytes = header.original_bytes;
+    const auto effort = compression_controller.Next(
+        static_cast<double>(capture_ring.Size()) / static_cast<double>(capture_ring.Capacity()),
+        unread_bytes_hint
     );
 
-    if (status != MZ_OK) {
-        return std::vector<char>(data, data + bytes);
+    auto chunk_codec = codec.load(std::memory_order_relaxed);
+    if (effort == CompressionEffort_t::Store) {
+        chunk_codec = RecordingCodec_t::None;
+    }
+
+    size_t compressed_bytes = 0;
+    if (chunk_codec == RecordingCodec_t::Lossless) {
+        compressed_bytes = lossless_encoder.Encode(raw_chunk.pcm_data.data(), bytes, pcm_format, pcm_channels, compression_scratch);
+        if (!compressed_bytes) { // format not supported
+            chunk_codec = RecordingCodec_t::Deflate;
+        }
+    }
+    uint16_t filter_id = 0;
+    if (chunk_codec == RecordingCodec_t::Deflate) {
+        if (!deflate_compressor) { // once per buffer manager, it's a few hundred KB
+            deflate_compressor = std::make_unique<tdefl_compressor>();
+        }
+
+        auto deflate_input = raw_chunk.pcm_data.data();
+        filter_id = PcmFilterId(filter.load(std::memory_order_relaxed), pcm_format, pcm_channels);
+        if (filter_id) {
+            filter_scratch.resize(bytes);
+            if (PcmFilterApply(filter_id, deflate_input, bytes, filter_scratch.data())) {
+                deflate_input = filter_scratch.data();
+            } else { // partial frame
+                filter_id = 0;
+            }
+        }
+
+        const auto level = effort == CompressionEffort_t::High ? MZ_DEFAULT_LEVEL : MZ_BEST_SPEED;
+        compressed_bytes = compress_gzip(deflate_compressor.get(), level, deflate_input, bytes, compression_scratch);
+    }
+    if (chunk_codec != RecordingCodec_t::None) {
+        compression_controller.Report(bytes, compressed_bytes);
+    }
+
+    if (compressed_bytes && compressed_bytes < bytes) {
+        header.codec = static_cast<uint16_t>(chunk_codec);
+        header.filter = filter_id;
+        header.compressed_bytes = static_cast<uint32_t>(compressed_bytes);
+        return compression_scratch.data();
+    }
+
+    // raw, also when compression failed, didn't pay off or was skipped
+    header.codec = static_cast<uint16_t>(RecordingCodec_t::None);
+    header.compressed_bytes = bytes;
+    return raw_chunk.pcm_data.data();
+}
+
+void RecordingBufferMan::compress_pending_chunks()
+{
+    // we're the only consumer of the capture ring
+    for (auto raw_chunk = capture_ring.Front(); raw_chunk; raw_chunk = capture_ring.Front()) {
+        if (raw_chunk->seq < discard_before_seq.load(std::memory_order_acquire)) { // captured before ClearRecording()
+            capture_ring.Pop();
+            continue;
+        }
+
+        auto header = MicChunkHeaderSerialized_t{};
+        header.header_bytes = sizeof(header);
+        header.original_bytes = static_cast<uint32_t>(raw_chunk->pcm_data.size());
+        header.format = static_cast<uint32_t>(pcm_format);
+        header.sample_rate = pcm_sample_rate;
+        header.channels = static_cast<uint16_t>(pcm_channels);
+        header.seq = raw_chunk->seq;
+        header.frame_timestamp = raw_chunk->frame_timestamp;
+
+        // either the compression scratch or the raw pcm, copied once into the arena
+        const auto payload = compress_chunk(*raw_chunk, header);
+
+        {
+            std::lock_guard lock(mic_buffer_mtx);
+            if (header.seq >= discard_before_seq.load(std::memory_order_acquire)) { // ClearRecording() might have been called meanwhile
+                const auto chunk_bytes = sizeof(header) + header.compressed_bytes;
+                const auto budget = memory_budget.load(std::memory_order_relaxed);
+                if (budget && overflow_policy.load(std::memory_order_relaxed) == RecordingOverflowPolicy_t::DropNewest && mic_arena.SizeUnread() + chunk_bytes > budget) {
+                    overflow_stats.dropped_newest_chunks++;
+                } else {
+                    mic_arena.Push(header, payload);
+                    enforce_memory_budget();
+                }
+                publish_stats();
+            }
+            unread_bytes_hint = mic_arena.SizeUnread() + spill.SizeUnread();
+        }
+
+        capture_ring.Pop(); // 'payload' may point into it
+    }
+}
+
+void RecordingBufferMan::enforce_memory_budget()
+{
+    const auto budget = memory_budget.load(std::memory_order_relaxed);
+    if (!budget || view_source != ViewSource_t::None) { // the view's bytes can't move, this waits for the commit
+        return;
+    }
+
+    const auto policy = overflow_policy.load(std::memory_order_relaxed);
+    if (policy == RecordingOverflowPolicy_t::DropNewest) { // refused before being stored
+        return;
     }
 
-    compressed_data.resize(compressed_bytes);
-    return compressed_data;
+    while (mic_arena.SizeUnread() > budget && mic_arena.ChunksCount()) {
+        const auto header = mic_arena.OldestHeader();
+        if (policy == RecordingOverflowPolicy_t::Spill && spill_oldest_chunk(header)) {
+            overflow_stats.spilled_chunks++;
+        } else { // also when the spill file can't be written, memory is what we have to protect
+            overflow_stats.dropped_oldest_chunks++;
+        }
+        mic_arena.Consume(sizeof(header) + header.compressed_bytes);
+    }
 }
 
-static std::vector<char> decompress_gzip(const char *compressed_data, size_t compressed_data_size, size_t original_size)
+bool RecordingBufferMan::spill_oldest_chunk(const MicChunkHeaderSerialized_t &header)
 {
-    if (compressed_data_size == original_size) { // previous compression failed
-        return std::vector<char>(compressed_data, compressed_data + compressed_data_size);
+    if (!spill.IsOpen() && !spill.Open(spill_path.c_str())) {
+        return false;
     }
 
-    std::vector<char> decompressed_data(original_size);
+    const auto spilled_chunks = spill.ChunksCount();
+    if (spill.Push(header, mic_arena.OldestChunk())) {
+        return true;
+    }
 
-    auto decompressed_size = static_cast<mz_ulong>(original_size);
-    auto status = mz_uncompress(
-        reinterpret_cast<unsigned char*>(decompressed_data.data()), 
-        &decompressed_size, 
-        reinterpret_cast<const unsigned char*>(compressed_data), 
-        compressed_data_size);
+    // the file couldn't grow, nor be mapped back
+    overflow_stats.dropped_oldest_chunks += spilled_chunks - spill.ChunksCount();
+    return false;
+}
 
-    if (status != MZ_OK) {
-        return std::vector<char>(compressed_data, compressed_data + compressed_data_size);
+RecordingBufferMan::~RecordingBufferMan()
+{
+    StopWorker(); // the delivery thread flushes what's left
+    stop_delivery();
+}
+
+void RecordingBufferMan::ReserveCapture(size_t ring_chunks, size_t chunk_bytes)
+{
+    if (compression_worker.joinable()) {
+        return; // draining the ring
     }
 
-    decompressed_data.resize(decompressed_size);
-    return decompressed_data;
+    // StopWorker() left the ring empty
+    capture_ring.Reset(ring_chunks);
+    capture_ring.ForEachSlot([chunk_bytes](MicRawChunk_t &raw_chunk){
+        raw_chunk.pcm_data.reserve(chunk_bytes);
+    });
+}
+
+void RecordingBufferMan::SetPcmLayout(RecordingFormat_t format, unsigned int channels, uint32_t sample_rate)
+{
+    pcm_format = format;
+    pcm_channels = channels;
+    pcm_sample_rate = sample_rate;
+
+    std::lock_guard lock(mic_buffer_mtx);
+    pcm_bytes_per_ms = std::max(static_cast<double>(MicChunkFrameBytes(format, channels)) * sample_rate / 1000.0, 1.0);
+}
+
+void RecordingBufferMan::StartWorker()
+{
+    if (compression_worker.joinable()) {
+        return;
+    }
+
+    compression_controller.Reset();
+    worker_stop_requested.store(false, std::memory_order_release);
+    compression_worker = std::thread([this]{ compression_worker_loop(); });
+
+    std::lock_guard lock(mic_buffer_mtx);
+    worker_running = true;
+}
+
+void RecordingBufferMan::StopWorker()
+{
+    if (!compression_worker.joinable()) {
+        return;
+    }
+
+    worker_stop_requested.store(true, std::memory_order_release);
+    worker_wakeup.fetch_add(1, std::memory_order_release);
+    worker_wakeup.notify_one();
+    compression_worker.join();
+
+    // nothing else is coming
+    std::lock_guard lock(mic_buffer_mtx);
+    worker_running = false;
+    unread_cv.notify_all();
+}
+
+void RecordingBufferMan::SetCodec(RecordingCodec_t new_codec)
+{
+    codec.store(new_codec, std::memory_order_relaxed);
+}
+
+RecordingCodec_t RecordingBufferMan::GetCodec() const
+{
+    return codec.load(std::memory_order_relaxed);
+}
+
+void RecordingBufferMan::SetFilter(RecordingFilter_t new_filter)
+{
+    filter.store(new_filter, std::memory_order_relaxed);
+}
+
+RecordingFilter_t RecordingBufferMan::GetFilter() const
+{
+    return filter.load(std::memory_order_relaxed);
+}
+
+void RecordingBufferMan::SetMemoryBudget(size_t max_bytes)
+{
+    std::lock_guard lock(mic_buffer_mtx);
+    memory_budget.store(max_bytes, std::memory_order_relaxed);
+    enforce_memory_budget();
+    publish_stats();
+}
+
+size_t RecordingBufferMan::GetMemoryBudget() const
+{
+    return memory_budget.load(std::memory_order_relaxed);
 }
 
+void RecordingBufferMan::SetOverflowPolicy(RecordingOverflowPolicy_t policy)
+{
+    std::lock_guard lock(mic_buffer_mtx);
+    overflow_policy.store(policy, std::memory_order_relaxed);
+    enforce_memory_budget();
+    publish_stats();
+}
 
+RecordingOverflowPolicy_t RecordingBufferMan::GetOverflowPolicy() const
+{
+    return overflow_policy.load(std::memory_order_relaxed);
+}
+
+void RecordingBufferMan::SetSpillFilePath(const char *path)
+{
+    std::lock_guard lock(mic_buffer_mtx);
+    spill_path = path ? path : "";
+}
 
-void RecordingBufferMan::PushData(const char *data, uint32_t bytes)
+RecordingOverflowStats_t RecordingBufferMan::GetOverflowStats()
+{
+    std::lock_guard lock(mic_buffer_mtx);
+    auto stats = overflow_stats;
+    stats.spilled_unread_bytes = spill.SizeUnread();
+    return stats;
+}
+
+char* RecordingBufferMan::BeginPushData(uint32_t bytes, uint64_t frame_timestamp)
 {
     if (!bytes) {
+        return nullptr;
+    }
+
+    auto raw_chunk = capture_ring.BeginPush();
+    if (!raw_chunk) { // the compression worker is too slow, we can't block the audio thread
+        dropped_chunks.fetch_add(1, std::memory_order_relaxed);
+        // the lost period still takes a sequence number so readers see the gap
+        pushed_chunks.store(pushed_chunks.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        return nullptr;
+    }
+
+    if (raw_chunk->pcm_data.capacity() < bytes) { // period is bigger than what ReserveCapture() expected
+        CountRealtimeAllocation();
+    }
+    raw_chunk->pcm_data.resize(bytes); // no-op for same sized periods
+    raw_chunk->frame_timestamp = frame_timestamp;
+    pending_raw_chunk = raw_chunk;
+    return raw_chunk->pcm_data.data();
+}
+
+void RecordingBufferMan::CommitPushData()
+{
+    if (!pending_raw_chunk) {
         return;
     }
 
-    auto chunk = MicChunk_t{};
-    chunk.original_bytes = bytes;
-    chunk.compressed_data = compress_gzip(data, bytes);
-    mic_buffer.emplace_back(std::move(chunk));
+    const auto seq = pushed_chunks.load(std::memory_order_relaxed);
+    pending_raw_chunk->seq = seq;
+    pending_raw_chunk = nullptr;
+    capture_ring.CommitPush();
+    pushed_chunks.store(seq + 1, std::memory_order_release);
+
+    // wake up the compression worker, this never blocks
+    worker_wakeup.fetch_add(1, std::memory_order_release);
+    worker_wakeup.notify_one();
 }
 
 void RecordingBufferMan::Clear()
 {
-    mic_buffer.clear();
+    // chunks still waiting for compression are skipped by the worker
+    discard_before_seq.store(pushed_chunks.load(std::memory_order_acquire), std::memory_order_release);
+
+    std::lock_guard lock(mic_buffer_mtx);
+    mic_arena.Clear();
+    if (view_source == ViewSource_t::Spill) { // keep the view mapped
+        spill.Clear();
+    } else { // gives the disk space back
+        spill.Close();
+    }
+    clear_generation++;
+    publish_stats();
+}
+
+RecordingView_t RecordingBufferMan::view_unread_chunks(size_t max_bytes, ViewSource_t &source) const
+{
+    // spilled chunks are older than the ones in memory
+    if (spill.ChunksCount()) {
+        source = ViewSource_t::Spill;
+        return { spill.View(max_bytes), {} };
+    }
+
+    source = ViewSource_t::Memory;
+    return mic_arena.View(mic_arena.WholeChunksBytes(max_bytes));
+}
+
+void RecordingBufferMan::consume_unread_chunks(ViewSource_t source, size_t bytes)
+{
+    if (source == ViewSource_t::Spill) {
+        spill.Consume(bytes);
+    } else {
+        mic_arena.Consume(bytes);
+    }
+}
+
+void RecordingBufferMan::publish_stats()
+{
+    // spilled chunks are the oldest ones
+    const auto spilled_chunks = spill.ChunksCount();
+    const auto memory_chunks = mic_arena.ChunksCount();
+    uint64_t oldest_frame_timestamp = 0;
+    uint64_t newest_frame_timestamp = 0;
+    if (spilled_chunks) {
+        oldest_frame_timestamp = spill.OldestFrameTimestamp();
+        newest_frame_timestamp = spill.NewestFrameTimestamp();
+    }
+    if (memory_chunks) {
+        if (!spilled_chunks) {
+            oldest_frame_timestamp = mic_arena.OldestFrameTimestamp();
+        }
+        newest_frame_timestamp = mic_arena.NewestFrameTimestamp();
+    }
+
+    // single writer thanks to 'mic_buffer_mtx'
+    const auto version = stats_version.load(std::memory_order_relaxed);
+    stats_version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const auto unread_bytes = mic_arena.SizeUnread() + spill.SizeUnread();
+    stats_unread_bytes.store(unread_bytes, std::memory_order_relaxed);
+    stats_unread_original_bytes.store(mic_arena.OriginalBytes() + spill.OriginalBytes(), std::memory_order_relaxed);
+    stats_unread_chunks.store(memory_chunks + spilled_chunks, std::memory_order_relaxed);
+    stats_oldest_frame_timestamp.store(oldest_frame_timestamp, std::memory_order_relaxed);
+    stats_newest_frame_timestamp.store(newest_frame_timestamp, std::memory_order_relaxed);
+
+    stats_version.store(version + 2, std::memory_order_release);
+
+    notify_readers(unread_bytes);
+}
+
+void RecordingBufferMan::notify_readers(size_t unread_bytes)
+{
+    if (unread_waiters) {
+        unread_cv.notify_all();
+    }
+
+    // level triggered, a syscall only when the threshold is crossed
+    if (unread_event.IsOpen()) {
+        if (unread_bytes >= unread_event_min_bytes) {
+            unread_event.Set();
+        } else {
+            unread_event.Reset();
+        }
+    }
 }
 
 std::vector<char> RecordingBufferMan::GetUnreadChunks(size_t max_bytes)
 {
-    if (mic_buffer.empty() || !max_bytes) {
+    std::lock_guard lock(mic_buffer_mtx);
+
+    if (view_source != ViewSource_t::None) {
         return {};
     }
 
-    size_t bytes_to_copy = 0;
-    const auto mic_buffer_begin = mic_buffer.begin();
-    const auto mic_buffer_end = mic_buffer.end();
-    auto last_chunk_it = mic_buffer_begin;
-    for (; last_chunk_it != mic_buffer_end; ++last_chunk_it) {
-        auto chunk_size = sizeof(MicChunkHeaderSerialized_t) + last_chunk_it->compressed_data.size();
-        bytes_to_copy += chunk_size;
-        if (bytes_to_copy > max_bytes) {
-            bytes_to_copy -= chunk_size;
+    std::vector<char> ret{};
+    ret.reserve(std::min(max_bytes, mic_arena.SizeUnread() + spill.SizeUnread()));
+
+    // the spill first then memory, each of them in a single copy
+    for (;;) {
+        auto source = ViewSource_t::None;
+        const auto view = view_unread_chunks(max_bytes - ret.size(), source);
+        if (view.Empty()) {
             break;
         }
 
+        ret.insert(ret.end(), view.first.begin(), view.first.end());
+        ret.insert(ret.end(), view.second.begin(), view.second.end());
+        consume_unread_chunks(source, view.Size());
     }
 
-    if (!bytes_to_copy) {
+    publish_stats();
+    return ret;
+}
+
+RecordingView_t RecordingBufferMan::hold_view(size_t max_bytes)
+{
+    if (view_source != ViewSource_t::None) {
         return {};
     }
 
-    std::vector<char> ret{};
-    ret.reserve(bytes_to_copy);
+    auto source = ViewSource_t::None;
+    const auto view = view_unread_chunks(max_bytes, source);
+    if (view.Empty()) {
+        return {};
+    }
 
-    for (auto chunk_it = mic_buffer_begin; chunk_it != last_chunk_it; ++chunk_it) {
-        auto header = MicChunkHeaderSerialized_t{};
-        header.original_bytes = chunk_it->original_bytes;
-        header.compressed_bytes = static_cast<uint32_t>(chunk_it->compressed_data.size());
-        ret.insert(ret.end(), reinterpret_cast<const char *>(&header), reinterpret_cast<const char *>(&header) + sizeof(header)); // header
-        ret.insert(ret.end(), chunk_it->compressed_data.begin(), chunk_it->compressed_data.end()); // compressed data
+    if (source == ViewSource_t::Memory) {
+        mic_arena.Pin();
     }
+    view_source = source;
+    held_view = view;
+    view_generation = clear_generation;
+    return view;
+}
 
-    mic_buffer.erase(mic_buffer_begin, last_chunk_it);
+size_t RecordingBufferMan::commit_view(size_t consumed_bytes)
+{
+    if (view_source == ViewSource_t::None) {
+        return 0;
+    }
 
-    return ret;
+    size_t consumed_chunks_bytes = 0;
+    if (view_generation == clear_generation) { // otherwise ClearRecording() already took them
+        consumed_chunks_bytes = whole_chunks_bytes(held_view, consumed_bytes);
+        consume_unread_chunks(view_source, consumed_chunks_bytes);
+    }
+
+    if (view_source == ViewSource_t::Memory) {
+        mic_arena.Unpin();
+    }
+    view_source = ViewSource_t::None;
+    held_view = {};
+
+    enforce_memory_budget();
+    publish_stats();
+    return consumed_chunks_bytes;
+}
+
+bool RecordingBufferMan::delivery_batch_ready() const
+{
+    const auto unread_bytes = mic_arena.SizeUnread() + spill.SizeUnread();
+    if (!unread_bytes || view_source != ViewSource_t::None) {
+        return false;
+    }
+    if (!worker_running) { // whatever is left once the recording stops
+        return true;
+    }
+    if (!delivery_min_bytes && !delivery_min_ms) {
+        return true;
+    }
+
+    const auto unread_ms = static_cast<double>(mic_arena.OriginalBytes() + spill.OriginalBytes()) / pcm_bytes_per_ms;
+    return (delivery_min_bytes && unread_bytes >= delivery_min_bytes) || (delivery_min_ms && unread_ms >= delivery_min_ms);
+}
+
+void RecordingBufferMan::delivery_loop()
+{
+    std::unique_lock lock(mic_buffer_mtx);
+    unread_waiters++;
+
+    while (true) {
+        // a stop is only honored once nothing is ready, so the chunks left by StopWorker() are still delivered
+        if (!delivery_batch_ready()) {
+            if (delivery_stop_requested) {
+                break;
+            }
+            unread_cv.wait(lock);
+            continue;
+        }
+
+        // the spill and memory come in separate views, both are delivered before waiting again
+        const auto view = hold_view(static_cast<size_t>(-1));
+        lock.unlock();
+        delivery_callback(view);
+        lock.lock();
+        commit_view(static_cast<size_t>(-1));
+    }
+
+    unread_waiters--;
+}
+
+void RecordingBufferMan::stop_delivery()
+{
+    if (!delivery_thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard lock(mic_buffer_mtx);
+        delivery_stop_requested = true;
+        unread_cv.notify_all();
+    }
+    delivery_thread.join();
+}
+
+RecordingView_t RecordingBufferMan::ViewUnreadChunks(size_t max_bytes)
+{
+    std::lock_guard lock(mic_buffer_mtx);
+    return hold_view(max_bytes);
+}
+
+size_t RecordingBufferMan::CommitUnreadChunksView(size_t consumed_bytes)
+{
+    std::lock_guard lock(mic_buffer_mtx);
+    return commit_view(consumed_bytes);
+}
+
+void RecordingBufferMan::SetDeliveryCallback(RecordingCallback_t callback, size_t min_bytes, uint32_t min_ms)
+{
+    stop_delivery();
+    if (!callback) {
+        return;
+    }
+
+    {
+        std::lock_guard lock(mic_buffer_mtx);
+        delivery_callback = std::move(callback);
+        delivery_min_bytes = min_bytes;
+        delivery_min_ms = min_ms;
+        delivery_stop_requested = false;
+    }
+    delivery_thread = std::thread([this]{ delivery_loop(); });
 }
 
 size_t RecordingBufferMan::SizeUnread() const
 {
-    if (mic_buffer.empty()) {
-        return {};
+    return stats_unread_bytes.load(std::memory_order_relaxed);
+}
+
+RecordingBufferStats_t RecordingBufferMan::GetStats() const
+{
+    auto stats = RecordingBufferStats_t{};
+    for (;;) {
+        const auto version = stats_version.load(std::memory_order_acquire);
+        if (version & 1) { // being written, it's only a few stores
+            continue;
+        }
+
+        stats.unread_bytes = stats_unread_bytes.load(std::memory_order_relaxed);
+        stats.unread_original_bytes = stats_unread_original_bytes.load(std::memory_order_relaxed);
+        stats.unread_chunks = stats_unread_chunks.load(std::memory_order_relaxed);
+        stats.oldest_frame_timestamp = stats_oldest_frame_timestamp.load(std::memory_order_relaxed);
+        stats.newest_frame_timestamp = stats_newest_frame_timestamp.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (stats_version.load(std::memory_order_relaxed) == version) {
+            return stats;
+        }
     }
+}
 
-    return std::accumulate(mic_buffer.begin(), mic_buffer.end(), static_cast<size_t>(0), [](size_t acc, const MicChunk_t &item){
-        return acc + sizeof(MicChunkHeaderSerialized_t) + item.compressed_data.size();
-    });
+bool RecordingBufferMan::WaitUnread(size_t min_bytes, std::chrono::milliseconds timeout)
+{
+    min_bytes = std::max(min_bytes, static_cast<size_t>(1));
+    const auto unread_bytes = [this]{ return mic_arena.SizeUnread() + spill.SizeUnread(); };
+
+    std::unique_lock lock(mic_buffer_mtx);
+    unread_waiters++;
+    unread_cv.wait_for(lock, timeout, [&]{ return unread_bytes() >= min_bytes || !worker_running; });
+    unread_waiters--;
+
+    return unread_bytes() >= min_bytes;
+}
+
+int RecordingBufferMan::GetUnreadEventFd(size_t min_bytes)
+{
+    std::lock_guard lock(mic_buffer_mtx);
+
+    if (!unread_event.IsOpen() && !unread_event.Open()) {
+        return -1;
+    }
+
+    unread_event_min_bytes = std::max(min_bytes, static_cast<size_t>(1));
+    notify_readers(mic_arena.SizeUnread() + spill.SizeUnread());
+    return unread_event.Fd();
+}
+
+size_t RecordingBufferMan::DroppedChunks() const
+{
+    return dropped_chunks.load(std::memory_order_relaxed);
+}
+
+size_t RecordingBufferMan::RealtimeAllocations() const
+{
+    return realtime_allocations.load(std::memory_order_relaxed);
+}
+
+std::atomic<size_t>& RecordingBufferMan::RealtimeAllocationsCounter()
+{
+    return realtime_allocations;
 }
 
 
@@ -182,6 +716,7 @@ size_t RecordingBufferMan::SizeUnread() const
 AudioRecording::~AudioRecording()
 {
     StopRecording();
+    recording_buffer_man.SetDeliveryCallback(nullptr, 0, 0); // delivers what's left before it's cleared
     recording_buffer_man.Clear();
 }
 
@@ -217,23 +752,36 @@ bool AudioRecording::StartRecording(unsigned int sample_rate, unsigned char chan
         auto frame_bytes = ma_get_bytes_per_frame(pDevice->capture.format, pDevice->capture.channels) * frameCount;
         
         auto self_ref = static_cast<AudioRecording *>(pDevice->pUserData);
+        RealtimeAllocScope alloc_scope(self_ref->GetRecordingBufferMan()->RealtimeAllocationsCounter());
 
-        std::vector<char> pcm_data{};
-        auto gain_it = gain_filters.find(self_ref->GetRecordingRecordingFormat());
-        if (gain_filters.end() != gain_it) {
-            pcm_data = gain_it->second->ApplyGain(input_data, frame_bytes, self_ref->GetRecordingSoundGainPercentUnscaled());
-        } else {
-            pcm_data = std::vector<char>(input_data, input_data + frame_bytes);
+        // counts every period so the chunks can be placed in time even though silence isn't stored
+        const auto frame_timestamp = self_ref->recording_device.captured_frames;
+        self_ref->recording_device.captured_frames += frameCount;
+
+        auto buffer_man = self_ref->GetRecordingBufferMan();
+
+        // written in place into the capture ring, nothing is allocated here
+        auto pcm_data = buffer_man->BeginPushData(static_cast<uint32_t>(frame_bytes), frame_timestamp);
+        if (!pcm_data) {
+            return; // capture ring is full
         }
-        
-        auto filter_it = silence_filters.find(self_ref->GetRecordingRecordingFormat());
-        if (silence_filters.end() != filter_it) {
-            if (filter_it->second->IsSilencePcmData(pcm_data.data(), pcm_data.size(), self_ref->GetRecordingSoundThresholdPercentUnscaled())) {
-                return;
+
+        // gain and silence detection in a single pass, bound to the format when the recording started
+        auto pcm_processor = self_ref->recording_device.pcm_processor;
+        if (pcm_processor) {
+            auto is_silence = pcm_processor(
+                input_data, pcm_data, frame_bytes,
+                self_ref->GetRecordingSoundGainPercentUnscaled(),
+                self_ref->GetRecordingSoundThresholdPercentUnscaled()
+            );
+            if (is_silence) {
+                return; // not committed, the slot is reused for the next period
             }
+        } else {
+            std::memcpy(pcm_data, input_data, frame_bytes);
         }
 
-        self_ref->GetRecordingBufferMan()->PushData(pcm_data.data(), static_cast<uint32_t>(pcm_data.size()));
+        buffer_man->CommitPushData();
     };
 
     if (ma_device_init(nullptr, &recording_device.cfg, &recording_device.device) != MA_SUCCESS) {
@@ -243,9 +791,26 @@ bool AudioRecording::StartRecording(unsigned int sample_rate, unsigned char chan
     recording_device.sample_rate = sample_rate;
     recording_device.channels = channels;
     recording_device.format = format;
-
+    recording_device.pcm_processor = GetPcmProcessor(format);
+
+    // the callback gets periods at the client rate, the internal period is in the device's native rate
+    const auto period_frames = std::max<ma_uint64>(ma_calculate_frame_count_after_resampling(
+        recording_device.device.sampleRate,
+        recording_device.device.capture.internalSampleRate,
+        recording_device.device.capture.internalPeriodSizeInFrames
+    ), 1);
+    const auto ring_chunks = (static_cast<uint64_t>(recording_device.device.sampleRate) * capture_ring_ms / 1000 + period_frames - 1) / period_frames;
+    // one period with some headroom for irregular callbacks
+    const auto frame_bytes = ma_get_bytes_per_frame(recording_device.device.capture.format, recording_device.device.capture.channels);
+    const auto chunk_frames = period_frames + period_frames / 4;
+    recording_buffer_man.ReserveCapture(static_cast<size_t>(ring_chunks), static_cast<size_t>(chunk_frames) * frame_bytes);
+
+    recording_device.captured_frames = 0;
+    recording_buffer_man.SetPcmLayout(format, channels, recording_device.device.sampleRate);
+    recording_buffer_man.StartWorker();
     if (ma_device_start(&recording_device.device) != MA_SUCCESS) {
         ma_device_uninit(&recording_device.device);
+        recording_buffer_man.StopWorker();
         return false;
     }
 
@@ -260,6 +825,7 @@ void AudioRecording::StopRecording()
     }
 
     ma_device_uninit(&recording_device.device);
+    recording_buffer_man.StopWorker(); // after the device, so the last captured chunks get compressed
     recording_device.sample_rate = 0;
     is_recording_active = false;
 }
@@ -284,6 +850,26 @@ RecordingFormat_t AudioRecording::GetRecordingRecordingFormat() const
     return recording_device.format;
 }
 
+void AudioRecording::SetRecordingCodec(RecordingCodec_t codec)
+{
+    recording_buffer_man.SetCodec(codec);
+}
+
+RecordingCodec_t AudioRecording::GetRecordingCodec() const
+{
+    return recording_buffer_man.GetCodec();
+}
+
+void AudioRecording::SetRecordingFilter(RecordingFilter_t filter)
+{
+    recording_buffer_man.SetFilter(filter);
+}
+
+RecordingFilter_t AudioRecording::GetRecordingFilter() const
+{
+    return recording_buffer_man.GetFilter();
+}
+
 void AudioRecording::SetRecordingSoundThresholdPercent(float sound_threshold_percent) // [0.0, 100.0]
 {
     if (sound_threshold_percent < 0) {
@@ -322,43 +908,220 @@ float AudioRecording::GetRecordingSoundGainPercentUnscaled() const
     return recording_device.sound_gain;
 }
 
+void AudioRecording::SetRecordingMemoryBudget(size_t max_bytes)
+{
+    recording_buffer_man.SetMemoryBudget(max_bytes);
+}
+
+size_t AudioRecording::GetRecordingMemoryBudget() const
+{
+    return recording_buffer_man.GetMemoryBudget();
+}
+
+void AudioRecording::SetRecordingOverflowPolicy(RecordingOverflowPolicy_t policy)
+{
+    recording_buffer_man.SetOverflowPolicy(policy);
+}
+
+RecordingOverflowPolicy_t AudioRecording::GetRecordingOverflowPolicy() const
+{
+    return recording_buffer_man.GetOverflowPolicy();
+}
+
+void AudioRecording::SetRecordingSpillFilePath(const char *path)
+{
+    recording_buffer_man.SetSpillFilePath(path);
+}
+
+RecordingOverflowStats_t AudioRecording::GetRecordingOverflowStats()
+{
+    return recording_buffer_man.GetOverflowStats();
+}
+
 void AudioRecording::ClearRecording()
 {
     recording_buffer_man.Clear();
 }
 
-size_t AudioRecording::SizeUnreadRecording()
+size_t AudioRecording::SizeUnreadRecording() const
 {
     return recording_buffer_man.SizeUnread();
 }
 
+RecordingBufferStats_t AudioRecording::GetRecordingBufferStats() const
+{
+    return recording_buffer_man.GetStats();
+}
+
+bool AudioRecording::WaitForRecording(size_t min_bytes, std::chrono::milliseconds timeout)
+{
+    return recording_buffer_man.WaitUnread(min_bytes, timeout);
+}
+
+int AudioRecording::GetRecordingEventFd(size_t min_bytes)
+{
+    return recording_buffer_man.GetUnreadEventFd(min_bytes);
+}
+
+void AudioRecording::SetRecordingCallback(RecordingCallback_t callback, size_t min_bytes, uint32_t min_ms)
+{
+    recording_buffer_man.SetDeliveryCallback(std::move(callback), min_bytes, min_ms);
+}
+
+size_t AudioRecording::GetRecordingDroppedChunksCount() const
+{
+    return recording_buffer_man.DroppedChunks();
+}
+
+size_t AudioRecording::GetRecordingRealtimeAllocationsCount() const
+{
+    return recording_buffer_man.RealtimeAllocations();
+}
+
 std::vector<char> AudioRecording::GetUnreadRecording(size_t max_bytes)
 {
     return recording_buffer_man.GetUnreadChunks(max_bytes);
 }
 
-std::vector<char> AudioRecording::DecodeRecordingChunks(const char *chunks, size_t count)
+RecordingView_t AudioRecording::ViewUnreadRecording(size_t max_bytes)
+{
+    return recording_buffer_man.ViewUnreadChunks(max_bytes);
+}
+
+size_t AudioRecording::CommitUnreadRecordingView(size_t consumed_bytes)
+{
+    return recording_buffer_man.CommitUnreadChunksView(consumed_bytes);
+}
+
+size_t AudioRecording::GetRecordingChunksDecodedSize(const char *chunks, size_t count) const
 {
     if (!chunks || !count) {
-        return {};
+        return 0;
+    }
+
+    size_t decoded_bytes = 0;
+    auto header = MicChunkHeaderSerialized_t{};
+    const auto chunks_end = chunks + count;
+    for (auto payload = ReadMicChunkHeader(chunks, chunks_end, header); payload; payload = ReadMicChunkHeader(chunks, chunks_end, header)) {
+        decoded_bytes += header.original_bytes;
+        chunks = payload + header.compressed_bytes;
+    }
+
+    return decoded_bytes;
+}
+
+size_t AudioRecording::DecodeRecordingChunks(const char *chunks, size_t count, std::span<char> out)
+{
+    if (!chunks || !count) {
+        return 0;
+    }
+
+    MicChunkDecoder decoder{}; // reused across chunks
+    size_t decoded_bytes = 0;
+    auto header = MicChunkHeaderSerialized_t{};
+    const auto chunks_end = chunks + count;
+    for (auto payload = ReadMicChunkHeader(chunks, chunks_end, header); payload; payload = ReadMicChunkHeader(chunks, chunks_end, header)) {
+        if (out.size() - decoded_bytes < header.original_bytes) { // 'out' is full
+            break;
+        }
+
+        decoder.Decode(header, payload, out.data() + decoded_bytes);
+        decoded_bytes += header.original_bytes;
+        chunks = payload + header.compressed_bytes;
+    }
+
+    return decoded_bytes;
+}
+
+size_t AudioRecording::DecodeRecordingChunksParallel(const char *chunks, size_t count, std::span<char> out, unsigned int max_threads)
+{
+    if (!chunks || !count) {
+        return 0;
     }
 
-    std::vector<char> data{};
-    data.reserve(count + count / 2);
+    // every chunk is independent, find where each one lands in 'out' from the headers alone
+    struct ChunkJob_t
+    {
+        MicChunkHeaderSerialized_t header{};
+        const char *payload{};
+        size_t out_offset{};
+    };
 
+    std::vector<ChunkJob_t> jobs{};
+    size_t decoded_bytes = 0;
+    auto header = MicChunkHeaderSerialized_t{};
     const auto chunks_end = chunks + count;
-    while (chunks < chunks_end) {
-        auto chunk = reinterpret_cast<const MicChunkHeaderSerialized_t *>(chunks);
-        auto compressed_chunk = chunks + sizeof(MicChunkHeaderSerialized_t);
-        if (chunk->original_bytes != chunk->compressed_bytes) {
-            auto deco = decompress_gzip(compressed_chunk, chunk->compressed_bytes, chunk->original_bytes);
-            data.insert(data.end(), deco.begin(), deco.end());
-        } else { // previous compression failed
-            data.insert(data.end(), compressed_chunk, compressed_chunk + chunk->compressed_bytes);
+    for (auto payload = ReadMicChunkHeader(chunks, chunks_end, header); payload; payload = ReadMicChunkHeader(chunks, chunks_end, header)) {
+        if (out.size() - decoded_bytes < header.original_bytes) { // 'out' is full
+            break;
         }
-        chunks += sizeof(MicChunkHeaderSerialized_t) + chunk->compressed_bytes;
+
+        jobs.push_back({ header, payload, decoded_bytes });
+        decoded_bytes += header.original_bytes;
+        chunks = payload + header.compressed_bytes;
     }
 
+    if (!max_threads) {
+        max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    const auto threads_count = static_cast<unsigned int>(std::min<size_t>(max_threads, (jobs.size() + parallel_decode_batch - 1) / parallel_decode_batch));
+
+    // threads grab batches of chunks until none are left, the calling thread works too
+    std::atomic<size_t> next_job{};
+    const std::function<void()> decode_jobs = [&jobs, &next_job, out]{
+        MicChunkDecoder decoder{};
+        for (auto begin = next_job.fetch_add(parallel_decode_batch); begin < jobs.size(); begin = next_job.fetch_add(parallel_decode_batch)) {
+            const auto end = std::min(begin + parallel_decode_batch, jobs.size());
+            for (auto idx = begin; idx < end; ++idx) {
+                decoder.Decode(jobs[idx].header, jobs[idx].payload, out.data() + jobs[idx].out_offset);
+            }
+        }
+    };
+
+    decode_pool.Run(decode_jobs, threads_count ? threads_count - 1 : 0);
+
+    return decoded_bytes;
+}
+
+std::vector<char> AudioRecording::DecodeRecordingChunksParallel(const char *chunks, size_t count, unsigned int max_threads)
+{
+    std::vector<char> data(GetRecordingChunksDecodedSize(chunks, count));
+    data.resize(DecodeRecordingChunksParallel(chunks, count, data, max_threads));
+    return data;
+}
+
+std::vector<RecordingChunkInfo_t> AudioRecording::GetRecordingChunksInfo(const char *chunks, size_t count) const
+{
+    if (!chunks || !count) {
+        return {};
+    }
+
+    std::vector<RecordingChunkInfo_t> infos{};
+    auto header = MicChunkHeaderSerialized_t{};
+    const auto chunks_begin = chunks;
+    const auto chunks_end = chunks + count;
+    for (auto payload = ReadMicChunkHeader(chunks, chunks_end, header); payload; payload = ReadMicChunkHeader(chunks, chunks_end, header)) {
+        auto &info = infos.emplace_back();
+        info.offset = static_cast<size_t>(chunks - chunks_begin);
+        info.version = header.version;
+        info.codec = static_cast<RecordingCodec_t>(header.codec);
+        info.format = static_cast<RecordingFormat_t>(header.format);
+        info.sample_rate = header.sample_rate;
+        info.channels = header.channels;
+        info.seq = header.seq;
+        info.frame_timestamp = header.frame_timestamp;
+        info.original_bytes = header.original_bytes;
+        info.compressed_bytes = header.compressed_bytes;
+        chunks = payload + header.compressed_bytes;
+    }
+
+    return infos;
+}
+
+std::vector<char> AudioRecording::DecodeRecordingChunks(const char *chunks, size_t count)
+{
+    std::vector<char> data(GetRecordingChunksDecodedSize(chunks, count));
+    data.resize(DecodeRecordingChunks(chunks, count, data));
     return data;
 }
 
@@ -28,39 +28,179 @@ For more information, please refer to <https://unlicense.org>
 #pragma once
 
 #include <vector>
-#include <list>
+#include <span>
+#include <string>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <functional>
 #include <cstring> // size_t
 #include <cstdint> // uintxx_t
 
 #include "../../audio_man.hpp"
 #include "miniaudio/miniaudio.h"
+#include "miniz/miniz.h"
+#include "../rt_alloc_counter/rt_alloc_counter.hpp"
+#include "../spsc_ring/spsc_ring.hpp"
+#include "../event_fd/event_fd.hpp"
+#include "../worker_pool/worker_pool.hpp"
+#include "pcm_processor/pcm_processor.hpp"
+#include "lossless_codec/lossless_codec.hpp"
+#include "pcm_filter/pcm_filter.hpp"
+#include "mic_chunk/mic_chunk.hpp"
+#include "mic_chunk_spill/mic_chunk_spill.hpp"
+#include "mic_chunk_arena/mic_chunk_arena.hpp"
+#include "compression_controller/compression_controller.hpp"
 
 
-struct MicChunk_t
+struct MicRawChunk_t
 {
-    uint32_t original_bytes{};
-    std::vector<char> compressed_data{};
+    uint64_t seq{}; // capture order, used to discard chunks captured before ClearRecording()
+    uint64_t frame_timestamp{}; // device frames captured before this chunk since the recording started
+    std::vector<char> pcm_data{};
 };
 
-struct MicChunkHeaderSerialized_t
-{
-    uint32_t original_bytes{};
-    uint32_t compressed_bytes{};
-    // compressed data array is appended here
-};
-
-
 class RecordingBufferMan
 {
 private:
-    std::list<MicChunk_t> mic_buffer{};
+    // raw pcm filled by the audio thread (single producer), drained by the compression worker (single consumer)
+    SpscRing<MicRawChunk_t> capture_ring{};
+    std::atomic<uint64_t> pushed_chunks{}; // next sequence number, written by the audio thread only
+    std::atomic<size_t> dropped_chunks{};
+    std::atomic<size_t> realtime_allocations{}; // made in the capture callback, see RealtimeAllocScope
+    MicRawChunk_t *pending_raw_chunk{}; // between BeginPushData() and CommitPushData()
+
+    std::atomic<RecordingCodec_t> codec{ RecordingCodec_t::Deflate };
+    std::atomic<RecordingFilter_t> filter{ RecordingFilter_t::None };
+    std::atomic<uint64_t> discard_before_seq{};
+
+    std::thread compression_worker{};
+    std::atomic<bool> worker_stop_requested{};
+    std::atomic<uint32_t> worker_wakeup{}; // bumped by the audio thread, the worker sleeps on it
+    std::vector<char> compression_scratch{}; // worker only
+    std::vector<char> filter_scratch{}; // worker only
+    std::unique_ptr<tdefl_compressor> deflate_compressor{}; // worker only, reset for every chunk
+    LosslessEncoder lossless_encoder{}; // worker only
+    RecordingFormat_t pcm_format = RecordingFormat_t::Signed16;
+    unsigned int pcm_channels = 1;
+    uint32_t pcm_sample_rate{};
+    CompressionController compression_controller{}; // worker only
+    size_t unread_bytes_hint{}; // worker only, unread bytes as of the last chunk
+
+    // compressed chunks produced by the worker in wire format, shared by the worker and readers
+    MicChunkArena mic_arena{};
+    std::mutex mic_buffer_mtx{};
+
+    // at most one view handed out by ViewUnreadChunks(), guarded by 'mic_buffer_mtx'
+    enum class ViewSource_t { None, Spill, Memory };
+    ViewSource_t view_source = ViewSource_t::None;
+    RecordingView_t held_view{};
+    uint64_t view_generation{};
+    uint64_t clear_generation{}; // bumped by Clear(), a view of an older generation has nothing left to consume
+
+    // readers waiting for unread data, guarded by 'mic_buffer_mtx'
+    std::condition_variable unread_cv{};
+    size_t unread_waiters{};
+    bool worker_running{}; // waiters give up once the worker is stopped
+    EventFd unread_event{};
+    size_t unread_event_min_bytes = 1;
+
+    // pushes the unread chunks to 'delivery_callback' in batches, the settings are guarded by 'mic_buffer_mtx'
+    std::thread delivery_thread{};
+    RecordingCallback_t delivery_callback{};
+    size_t delivery_min_bytes{};
+    uint32_t delivery_min_ms{};
+    bool delivery_stop_requested{};
+    double pcm_bytes_per_ms = 1.0; // guarded by 'mic_buffer_mtx'
+
+    // snapshot of the unread chunks, written by publish_stats() only and read without locking (seqlock)
+    std::atomic<uint32_t> stats_version{}; // odd while being written
+    std::atomic<size_t> stats_unread_bytes{};
+    std::atomic<size_t> stats_unread_original_bytes{};
+    std::atomic<size_t> stats_unread_chunks{};
+    std::atomic<uint64_t> stats_oldest_frame_timestamp{};
+    std::atomic<uint64_t> stats_newest_frame_timestamp{};
+
+    // 'mic_arena' overflow, the budget and the policy are read under 'mic_buffer_mtx'
+    std::atomic<size_t> memory_budget{}; // 0 = unlimited
+    std::atomic<RecordingOverflowPolicy_t> overflow_policy{ RecordingOverflowPolicy_t::Spill };
+    std::string spill_path{}; // guarded by 'mic_buffer_mtx'
+    MicChunkSpill spill{}; // guarded by 'mic_buffer_mtx', every chunk in there is older than 'mic_arena'
+    RecordingOverflowStats_t overflow_stats{}; // guarded by 'mic_buffer_mtx'
+
+    void compression_worker_loop();
+    // fills the codec related fields of 'header', returns its payload
+    const char* compress_chunk(const MicRawChunk_t &raw_chunk, MicChunkHeaderSerialized_t &header);
+    void compress_pending_chunks();
+    // 'mic_buffer_mtx' must be held
+    void enforce_memory_budget();
+    bool spill_oldest_chunk(const MicChunkHeaderSerialized_t &header);
+    RecordingView_t view_unread_chunks(size_t max_bytes, ViewSource_t &source) const;
+    void consume_unread_chunks(ViewSource_t source, size_t bytes);
+    void publish_stats(); // after any change to the unread chunks
+    void notify_readers(size_t unread_bytes);
+    RecordingView_t hold_view(size_t max_bytes);
+    size_t commit_view(size_t consumed_bytes);
+    bool delivery_batch_ready() const;
+    void delivery_loop();
+    void stop_delivery(); // not from the callback
     
 public:
-    void PushData(const char *data, uint32_t bytes);
+    ~RecordingBufferMan();
+
+    // not thread safe, must be called while the capture device is stopped, does nothing while the worker runs
+    // sizes the capture ring to 'ring_chunks' periods and preallocates every slot for periods up to 'chunk_bytes'
+    void ReserveCapture(size_t ring_chunks, size_t chunk_bytes);
+
+    // not thread safe, must be called while the worker is stopped
+    // layout of the captured pcm, needed by the lossless codec and written to every chunk header
+    void SetPcmLayout(RecordingFormat_t format, unsigned int channels, uint32_t sample_rate);
+
+    void StartWorker();
+    // compresses whatever is still pending in the capture ring before returning
+    void StopWorker();
+
+    void SetCodec(RecordingCodec_t new_codec);
+    RecordingCodec_t GetCodec() const;
+
+    void SetFilter(RecordingFilter_t new_filter);
+    RecordingFilter_t GetFilter() const;
+
+    // lowering the budget applies the policy right away, DropNewest only refuses new chunks
+    void SetMemoryBudget(size_t max_bytes);
+    size_t GetMemoryBudget() const;
+    void SetOverflowPolicy(RecordingOverflowPolicy_t policy);
+    RecordingOverflowPolicy_t GetOverflowPolicy() const;
+    // used the next time the spill file is created
+    void SetSpillFilePath(const char *path);
+    RecordingOverflowStats_t GetOverflowStats();
+
+    // *** called from the audio thread only *** //
+    // returns a buffer to write 'bytes' of pcm data into, or nullptr if the capture ring is full
+    // 'frame_timestamp' is the count of device frames captured before this period
+    char* BeginPushData(uint32_t bytes, uint64_t frame_timestamp);
+    // publish the buffer returned by BeginPushData(), not calling this discards it
+    void CommitPushData();
+    // *** called from the audio thread only *** //
+
     void Clear();
     std::vector<char> GetUnreadChunks(size_t max_bytes);
+    // see AudioMan::ViewUnreadRecording()
+    RecordingView_t ViewUnreadChunks(size_t max_bytes);
+    size_t CommitUnreadChunksView(size_t consumed_bytes);
     size_t SizeUnread() const;
+    RecordingBufferStats_t GetStats() const;
+    // see AudioMan::WaitForRecording() and AudioMan::GetRecordingEventFd()
+    bool WaitUnread(size_t min_bytes, std::chrono::milliseconds timeout);
+    int GetUnreadEventFd(size_t min_bytes);
+    // see AudioMan::SetRecordingCallback()
+    void SetDeliveryCallback(RecordingCallback_t callback, size_t min_bytes, uint32_t min_ms);
+    size_t DroppedChunks() const;
+    size_t RealtimeAllocations() const;
+    std::atomic<size_t>& RealtimeAllocationsCounter();
 };
 
 struct RecordingDevice_t {
@@ -69,6 +209,8 @@ struct RecordingDevice_t {
     unsigned int sample_rate{};
     unsigned char channels{};
     RecordingFormat_t format{};
+    PcmProcessorFn pcm_processor{};
+    uint64_t captured_frames{}; // audio thread only, silent and dropped periods included
     float sound_gain = 1.0f;
     float sound_threshold = 0; // allow anything
 };
@@ -76,8 +218,14 @@ struct RecordingDevice_t {
 class AudioRecording
 {
 private:
+    // chunks a decoding thread takes at once, also the least amount of work worth a thread
+    static constexpr size_t parallel_decode_batch = 32;
+    // how much audio the capture ring holds while the compression worker is busy, rounded up to a power of 2 periods
+    static constexpr uint32_t capture_ring_ms = 1000;
+
     RecordingBufferMan recording_buffer_man{};
     RecordingDevice_t recording_device{}; 
+    WorkerPool decode_pool{}; // DecodeRecordingChunksParallel() helpers, idle between calls
     bool is_recording_active = false;   
 
 public:
@@ -91,6 +239,19 @@ public:
     unsigned char GetRecordingChannelsCount() const;
     RecordingFormat_t GetRecordingRecordingFormat() const;
 
+    void SetRecordingCodec(RecordingCodec_t codec);
+    RecordingCodec_t GetRecordingCodec() const;
+
+    void SetRecordingFilter(RecordingFilter_t filter);
+    RecordingFilter_t GetRecordingFilter() const;
+
+    void SetRecordingMemoryBudget(size_t max_bytes);
+    size_t GetRecordingMemoryBudget() const;
+    void SetRecordingOverflowPolicy(RecordingOverflowPolicy_t policy);
+    RecordingOverflowPolicy_t GetRecordingOverflowPolicy() const;
+    void SetRecordingSpillFilePath(const char *path);
+    RecordingOverflowStats_t GetRecordingOverflowStats();
+
     void SetRecordingSoundThresholdPercent(float sound_threshold_percent); // [0.0, 100.0]
     float GetRecordingSoundThresholdPercent() const;
     float GetRecordingSoundThresholdPercentUnscaled() const;
@@ -100,9 +261,22 @@ public:
     float GetRecordingSoundGainPercentUnscaled() const;
 
     void ClearRecording();
-    size_t SizeUnreadRecording();
+    size_t SizeUnreadRecording() const;
+    RecordingBufferStats_t GetRecordingBufferStats() const;
+    bool WaitForRecording(size_t min_bytes, std::chrono::milliseconds timeout);
+    int GetRecordingEventFd(size_t min_bytes);
+    void SetRecordingCallback(RecordingCallback_t callback, size_t min_bytes, uint32_t min_ms);
+    size_t GetRecordingDroppedChunksCount() const;
+    size_t GetRecordingRealtimeAllocationsCount() const;
     std::vector<char> GetUnreadRecording(size_t max_bytes);
+    RecordingView_t ViewUnreadRecording(size_t max_bytes);
+    size_t CommitUnreadRecordingView(size_t consumed_bytes);
+    size_t GetRecordingChunksDecodedSize(const char *chunks, size_t count) const;
+    size_t DecodeRecordingChunks(const char *chunks, size_t count, std::span<char> out);
     std::vector<char> DecodeRecordingChunks(const char *chunks, size_t count);
+    std::vector<RecordingChunkInfo_t> GetRecordingChunksInfo(const char *chunks, size_t count) const;
+    size_t DecodeRecordingChunksParallel(const char *chunks, size_t count, std::span<char> out, unsigned int max_threads);
+    std::vector<char> DecodeRecordingChunksParallel(const char *chunks, size_t count, unsigned int max_threads);
 
     RecordingBufferMan* GetRecordingBufferMan();
 
@@ -0,0 +1,461 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#if defined(_WIN32)
+    #include <io.h> // _chsize_s
+#else
+    #include <unistd.h> // ftruncate
+#endif
+
+#include <algorithm>
+#include <cstring> // std::memcpy
+
+#include "recording_archive.hpp"
+
+
+
+// drops whatever a failed write left in the file past 'offset'
+static bool truncate_file(std::FILE *file, uint64_t offset)
+{
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+
+#if defined(_WIN32)
+    return _chsize_s(_fileno(file), static_cast<__int64>(offset)) == 0 && _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return ftruncate(fileno(file), static_cast<off_t>(offset)) == 0 && fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+// *** writer *** //
+RecordingArchiveWriterImpl::~RecordingArchiveWriterImpl()
+{
+    Close();
+}
+
+bool RecordingArchiveWriterImpl::Open(const char *path)
+{
+    Close();
+
+    file = std::fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+
+    const auto header = RecordingArchiveHeader_t{};
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    file_offset = sizeof(header);
+    index.clear();
+    end_frame = 0;
+    failed = false;
+    return true;
+}
+
+bool RecordingArchiveWriterImpl::Append(const char *chunks, size_t count)
+{
+    if (!file || failed || !chunks || !count) {
+        return false;
+    }
+
+    // validate every chunk before writing anything so a rejected stream leaves the archive untouched
+    pending_entries.clear();
+    auto header = MicChunkHeaderSerialized_t{};
+    auto layout_known = !index.empty();
+    auto next_frame = end_frame;
+    auto pending_format = format;
+    auto pending_sample_rate = sample_rate;
+    auto pending_channels = channels;
+    const auto chunks_begin = chunks;
+    const auto chunks_end = chunks + count;
+    for (auto payload = ReadMicChunkHeader(chunks, chunks_end, header); payload; payload = ReadMicChunkHeader(chunks, chunks_end, header)) {
+        if (header.version < mic_chunk_version) { // legacy chunks have no timestamp
+            return false;
+        }
+
+        const auto chunk_format = static_cast<RecordingFormat_t>(header.format);
+        if (!layout_known) {
+            pending_format = chunk_format;
+            pending_sample_rate = header.sample_rate;
+            pending_channels = header.channels;
+            layout_known = true;
+        } else if (chunk_format != pending_format || header.sample_rate != pending_sample_rate || header.channels != pending_channels) {
+            return false;
+        }
+
+        const auto chunk_frame_bytes = MicChunkFrameBytes(chunk_format, header.channels);
+        if (!chunk_frame_bytes || header.original_bytes % chunk_frame_bytes || header.frame_timestamp < next_frame) {
+            return false;
+        }
+
+        auto &entry = pending_entries.emplace_back();
+        entry.frame_timestamp = header.frame_timestamp;
+        entry.offset = file_offset + static_cast<uint64_t>(chunks - chunks_begin);
+        entry.frames = static_cast<uint32_t>(header.original_bytes / chunk_frame_bytes);
+        entry.chunk_bytes = static_cast<uint32_t>(payload + header.compressed_bytes - chunks);
+        next_frame = entry.frame_timestamp + entry.frames;
+        chunks = payload + header.compressed_bytes;
+    }
+
+    if (chunks != chunks_end) { // truncated or garbage at the end
+        return false;
+    }
+
+    if (std::fwrite(chunks_begin, 1, count, file) != count) {
+        // the index and 'file_offset' still describe the file without these bytes
+        failed = !truncate_file(file, file_offset);
+        return false;
+    }
+
+    format = pending_format;
+    sample_rate = pending_sample_rate;
+    channels = pending_channels;
+    end_frame = next_frame;
+    file_offset += count;
+    index.insert(index.end(), pending_entries.begin(), pending_entries.end());
+    return true;
+}
+
+bool RecordingArchiveWriterImpl::Close()
+{
+    if (!file) {
+        return false;
+    }
+
+    if (failed) { // no index, readers scan the chunks up to the broken tail
+        std::fclose(file);
+        file = nullptr;
+        index.clear();
+        return false;
+    }
+
+    static constexpr char padding[8]{};
+    const auto padding_bytes = static_cast<size_t>((8 - file_offset % 8) % 8);
+    auto footer = RecordingArchiveFooter_t{};
+    footer.index_offset = file_offset + padding_bytes;
+    footer.entries_count = index.size();
+
+    auto ok = std::fwrite(padding, 1, padding_bytes, file) == padding_bytes
+        && (index.empty() || std::fwrite(index.data(), sizeof(RecordingArchiveIndexEntry_t), index.size(), file) == index.size())
+        && std::fwrite(&footer, sizeof(footer), 1, file) == 1;
+    ok = std::fclose(file) == 0 && ok;
+
+    file = nullptr;
+    index.clear();
+    return ok;
+}
+
+bool RecordingArchiveWriterImpl::IsOpen() const
+{
+    return file != nullptr;
+}
+// *** writer *** //
+
+
+
+// *** reader *** //
+RecordingArchiveIndexEntry_t RecordingArchiveReaderImpl::index_entry(size_t idx) const
+{
+    if (!index_data) {
+        return scanned_index[idx];
+    }
+
+    auto entry = RecordingArchiveIndexEntry_t{};
+    std::memcpy(&entry, index_data + idx * sizeof(entry), sizeof(entry));
+    return entry;
+}
+
+bool RecordingArchiveReaderImpl::is_index_consistent(size_t chunks_offset, size_t chunks_end) const
+{
+    uint64_t next_offset = chunks_offset;
+    uint64_t next_frame = 0;
+    for (size_t idx = 0; idx < entries_count; ++idx) {
+        const auto entry = index_entry(idx);
+        if (entry.offset < next_offset || entry.offset > chunks_end || entry.chunk_bytes < sizeof(MicChunkHeaderSerialized_t)
+            || entry.chunk_bytes > chunks_end - entry.offset || entry.frame_timestamp < next_frame) {
+            return false;
+        }
+
+        next_offset = entry.offset + entry.chunk_bytes;
+        next_frame = entry.frame_timestamp + entry.frames;
+    }
+    return true;
+}
+
+void RecordingArchiveReaderImpl::scan_chunks(size_t chunks_offset, size_t chunks_end)
+{
+    scanned_index.clear();
+
+    auto header = MicChunkHeaderSerialized_t{};
+    const auto data = mapped_file.Data();
+    auto chunk = data + chunks_offset;
+    uint64_t next_frame = 0;
+    for (auto payload = ReadMicChunkHeader(chunk, data + chunks_end, header); payload; payload = ReadMicChunkHeader(chunk, data + chunks_end, header)) {
+        const auto chunk_frame_bytes = MicChunkFrameBytes(static_cast<RecordingFormat_t>(header.format), header.channels);
+        if (header.version < mic_chunk_version || !chunk_frame_bytes || header.frame_timestamp < next_frame) {
+            break; // most likely the tail of an interrupted write
+        }
+
+        auto &entry = scanned_index.emplace_back();
+        entry.frame_timestamp = header.frame_timestamp;
+        entry.offset = static_cast<uint64_t>(chunk - data);
+        entry.frames = static_cast<uint32_t>(header.original_bytes / chunk_frame_bytes);
+        entry.chunk_bytes = static_cast<uint32_t>(payload + header.compressed_bytes - chunk);
+        next_frame = entry.frame_timestamp + entry.frames;
+        chunk = payload + header.compressed_bytes;
+    }
+
+    entries_count = scanned_index.size();
+}
+
+bool RecordingArchiveReaderImpl::find_range(uint64_t t0, uint64_t t1, size_t &first, size_t &last, uint64_t &begin_frame, uint64_t &end_frame) const
+{
+    if (t0 >= t1 || !entries_count) {
+        return false;
+    }
+
+    // first chunk ending after t0, the chunks are sorted and don't overlap so their ends are sorted too
+    size_t low = 0;
+    size_t high = entries_count;
+    while (low < high) {
+        const auto mid = low + (high - low) / 2;
+        const auto entry = index_entry(mid);
+        if (entry.frame_timestamp + entry.frames <= t0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    first = low;
+    last = low;
+    while (last < entries_count && index_entry(last).frame_timestamp < t1) {
+        ++last;
+    }
+    if (first == last) {
+        return false;
+    }
+
+    const auto last_entry = index_entry(last - 1);
+    begin_frame = std::max(t0, index_entry(first).frame_timestamp);
+    end_frame = std::min(t1, last_entry.frame_timestamp + last_entry.frames);
+    return begin_frame < end_frame;
+}
+
+bool RecordingArchiveReaderImpl::Open(const char *path)
+{
+    Close();
+
+    if (!mapped_file.OpenRead(path)) {
+        return false;
+    }
+
+    const auto data = mapped_file.Data();
+    const auto size = mapped_file.Size();
+    auto header = RecordingArchiveHeader_t{};
+    if (size < sizeof(header)) {
+        Close();
+        return false;
+    }
+
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != recording_archive_magic || header.header_bytes < sizeof(header) || header.header_bytes > size) {
+        Close();
+        return false;
+    }
+
+    // use the index if the archive was closed properly
+    auto footer = RecordingArchiveFooter_t{};
+    auto chunks_end = size;
+    if (size >= header.header_bytes + sizeof(footer)) {
+        std::memcpy(&footer, data + size - sizeof(footer), sizeof(footer));
+        // compared piecewise, a crafted offset or count must not wrap around
+        const auto index_end = size - sizeof(footer);
+        const auto index_valid = footer.magic == recording_archive_index_magic
+            && footer.footer_bytes == sizeof(footer)
+            && footer.index_offset >= header.header_bytes
+            && footer.index_offset <= index_end
+            && footer.entries_count <= (index_end - footer.index_offset) / sizeof(RecordingArchiveIndexEntry_t)
+            && footer.entries_count * sizeof(RecordingArchiveIndexEntry_t) == index_end - footer.index_offset;
+        if (index_valid) {
+            index_data = data + footer.index_offset;
+            entries_count = static_cast<size_t>(footer.entries_count);
+            if (is_index_consistent(header.header_bytes, static_cast<size_t>(footer.index_offset))) {
+                chunks_end = static_cast<size_t>(footer.index_offset);
+            } else {
+                index_data = nullptr;
+                entries_count = 0;
+            }
+        }
+    }
+    if (!index_data) {
+        scan_chunks(header.header_bytes, chunks_end);
+    }
+
+    // the layout is the same for every chunk, take it from the first one
+    if (entries_count) {
+        auto chunk_header = MicChunkHeaderSerialized_t{};
+        const auto first_entry = index_entry(0);
+        if (first_entry.offset >= chunks_end || !ReadMicChunkHeader(data + first_entry.offset, data + chunks_end, chunk_header)) {
+            Close();
+            return false;
+        }
+
+        format = static_cast<RecordingFormat_t>(chunk_header.format);
+        sample_rate = chunk_header.sample_rate;
+        channels = chunk_header.channels;
+        frame_bytes = MicChunkFrameBytes(format, channels);
+    }
+
+    return true;
+}
+
+void RecordingArchiveReaderImpl::Close()
+{
+    mapped_file.Close();
+    index_data = nullptr;
+    entries_count = 0;
+    scanned_index.clear();
+    format = {};
+    sample_rate = 0;
+    channels = 0;
+    frame_bytes = 0;
+}
+
+bool RecordingArchiveReaderImpl::IsOpen() const
+{
+    return mapped_file.IsOpen();
+}
+
+RecordingFormat_t RecordingArchiveReaderImpl::GetFormat() const
+{
+    return format;
+}
+
+uint32_t RecordingArchiveReaderImpl::GetSampleRate() const
+{
+    return sample_rate;
+}
+
+uint16_t RecordingArchiveReaderImpl::GetChannelsCount() const
+{
+    return channels;
+}
+
+uint64_t RecordingArchiveReaderImpl::GetBeginFrame() const
+{
+    return entries_count ? index_entry(0).frame_timestamp : 0;
+}
+
+uint64_t RecordingArchiveReaderImpl::GetEndFrame() const
+{
+    if (!entries_count) {
+        return 0;
+    }
+
+    const auto last_entry = index_entry(entries_count - 1);
+    return last_entry.frame_timestamp + last_entry.frames;
+}
+
+size_t RecordingArchiveReaderImpl::GetRangeDecodedSize(uint64_t t0, uint64_t t1) const
+{
+    size_t first = 0;
+    size_t last = 0;
+    uint64_t begin_frame = 0;
+    uint64_t end_frame = 0;
+    if (!find_range(t0, t1, first, last, begin_frame, end_frame)) {
+        return 0;
+    }
+
+    return static_cast<size_t>(end_frame - begin_frame) * frame_bytes;
+}
+
+size_t RecordingArchiveReaderImpl::DecodeRange(uint64_t t0, uint64_t t1, std::span<char> out) const
+{
+    size_t first = 0;
+    size_t last = 0;
+    uint64_t begin_frame = 0;
+    uint64_t end_frame = 0;
+    if (!find_range(t0, t1, first, last, begin_frame, end_frame)) {
+        return 0;
+    }
+
+    const auto decoded_bytes = static_cast<size_t>(end_frame - begin_frame) * frame_bytes;
+    if (out.size() < decoded_bytes) {
+        return 0;
+    }
+
+    // periods dropped as silence are filled back in so the output stays time aligned
+    const char silence = format == RecordingFormat_t::Unsigned8 ? static_cast<char>(0x80) : 0;
+    const auto data = mapped_file.Data();
+    const auto data_end = data + mapped_file.Size();
+    MicChunkDecoder decoder{};
+    std::vector<char> scratch{}; // chunks cut by the range
+    auto cursor = begin_frame;
+    auto dst = out.data();
+    const auto dst_end = dst + decoded_bytes;
+    for (auto idx = first; idx < last; ++idx) {
+        // Open() checked the index, the clamps only keep a corrupt one from writing past 'out'
+        const auto entry = index_entry(idx);
+        if (entry.frame_timestamp > cursor) {
+            const auto gap_bytes = std::min(static_cast<size_t>(entry.frame_timestamp - cursor) * frame_bytes, static_cast<size_t>(dst_end - dst));
+            std::memset(dst, silence, gap_bytes);
+            dst += gap_bytes;
+            cursor = entry.frame_timestamp;
+        }
+
+        const auto copy_end = std::min(end_frame, entry.frame_timestamp + entry.frames);
+        if (copy_end <= cursor) {
+            continue;
+        }
+
+        auto header = MicChunkHeaderSerialized_t{};
+        auto payload = entry.offset < mapped_file.Size() ? ReadMicChunkHeader(data + entry.offset, data_end, header) : nullptr;
+        const auto copy_bytes = std::min(static_cast<size_t>(copy_end - cursor) * frame_bytes, static_cast<size_t>(dst_end - dst));
+        if (!payload || header.original_bytes != static_cast<size_t>(entry.frames) * frame_bytes) { // index and chunk disagree
+            std::memset(dst, silence, copy_bytes);
+        } else if (cursor == entry.frame_timestamp && copy_bytes == header.original_bytes) {
+            decoder.Decode(header, payload, dst);
+        } else {
+            scratch.resize(header.original_bytes);
+            decoder.Decode(header, payload, scratch.data());
+            std::memcpy(dst, scratch.data() + static_cast<size_t>(cursor - entry.frame_timestamp) * frame_bytes, copy_bytes);
+        }
+        dst += copy_bytes;
+        cursor = copy_end;
+    }
+    std::memset(dst, silence, static_cast<size_t>(dst_end - dst));
+
+    return decoded_bytes;
+}
+// *** reader *** //
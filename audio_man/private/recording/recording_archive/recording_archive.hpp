@@ -0,0 +1,133 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#pragma once
+
+#include <vector>
+#include <span>
+#include <cstdio> // std::FILE
+#include <cstring> // size_t
+#include <cstdint> // uintxx_t
+
+#include "../../../audio_man.hpp"
+#include "../../mapped_file/mapped_file.hpp"
+#include "../mic_chunk/mic_chunk.hpp"
+
+
+// on-disk archive of one recording:
+// [RecordingArchiveHeader_t][chunks exactly as GetUnreadRecording() returns them][padding to 8 bytes][RecordingArchiveIndexEntry_t]...[RecordingArchiveFooter_t]
+// the index and the footer are written when the archive is closed, archives which were never closed are indexed by scanning their chunks
+
+static constexpr uint32_t recording_archive_magic = 0x52414D41; // "AMAR"
+static constexpr uint32_t recording_archive_index_magic = 0x58494D41; // "AMIX"
+static constexpr uint16_t recording_archive_version = 1;
+
+struct RecordingArchiveHeader_t
+{
+    uint32_t magic = recording_archive_magic;
+    uint16_t version = recording_archive_version;
+    uint16_t header_bytes = sizeof(RecordingArchiveHeader_t);
+};
+
+// sorted by 'frame_timestamp', chunks never overlap
+struct RecordingArchiveIndexEntry_t
+{
+    uint64_t frame_timestamp{};
+    uint64_t offset{}; // of the chunk header from the start of the file
+    uint32_t frames{};
+    uint32_t chunk_bytes{}; // header included
+};
+
+struct RecordingArchiveFooter_t
+{
+    uint64_t index_offset{};
+    uint64_t entries_count{};
+    uint32_t magic = recording_archive_index_magic;
+    uint16_t version = recording_archive_version;
+    uint16_t footer_bytes = sizeof(RecordingArchiveFooter_t);
+};
+
+
+class RecordingArchiveWriterImpl
+{
+private:
+    std::FILE *file{};
+    uint64_t file_offset{};
+    std::vector<RecordingArchiveIndexEntry_t> index{};
+    std::vector<RecordingArchiveIndexEntry_t> pending_entries{}; // of the chunks being appended
+
+    // every chunk must have the layout of the first one
+    RecordingFormat_t format{};
+    uint32_t sample_rate{};
+    uint16_t channels{};
+    uint64_t end_frame{}; // of the last chunk
+    bool failed{}; // a write failed and couldn't be undone, nothing more is written
+
+public:
+    ~RecordingArchiveWriterImpl();
+
+    bool Open(const char *path);
+    bool Append(const char *chunks, size_t count);
+    bool Close();
+    bool IsOpen() const;
+};
+
+class RecordingArchiveReaderImpl
+{
+private:
+    MappedFile mapped_file{};
+    const char *index_data{}; // inside the mapping, not aligned
+    size_t entries_count{};
+    std::vector<RecordingArchiveIndexEntry_t> scanned_index{}; // archives which were never closed
+
+    RecordingFormat_t format{};
+    uint32_t sample_rate{};
+    uint16_t channels{};
+    size_t frame_bytes{};
+
+    RecordingArchiveIndexEntry_t index_entry(size_t idx) const;
+    // the footer index may still be corrupt, its chunks must be sorted, not overlap and lie in [chunks_offset, chunks_end)
+    bool is_index_consistent(size_t chunks_offset, size_t chunks_end) const;
+    void scan_chunks(size_t chunks_offset, size_t chunks_end);
+    // chunks [first, last) overlap [t0, t1) which is clamped to [begin_frame, end_frame)
+    bool find_range(uint64_t t0, uint64_t t1, size_t &first, size_t &last, uint64_t &begin_frame, uint64_t &end_frame) const;
+
+public:
+    bool Open(const char *path);
+    void Close();
+    bool IsOpen() const;
+
+    RecordingFormat_t GetFormat() const;
+    uint32_t GetSampleRate() const;
+    uint16_t GetChannelsCount() const;
+    uint64_t GetBeginFrame() const;
+    uint64_t GetEndFrame() const;
+
+    size_t GetRangeDecodedSize(uint64_t t0, uint64_t t1) const;
+    size_t DecodeRange(uint64_t t0, uint64_t t1, std::span<char> out) const;
+};
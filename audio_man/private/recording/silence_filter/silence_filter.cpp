@@ -26,13 +26,11 @@ For more information, please refer to <https://unlicense.org>
 */
 
 #include "silence_filter.hpp"
+#include "silence_filter_kernels.hpp"
 #include <cmath>
 #include <cstdint> // intxx_t
 
 
-// https://en.wikipedia.org/wiki/Audio_bit_depth
-
-
 bool MicSilenceFilterPcmF32::IsSilencePcmData(const char *data, size_t count, float sound_threshold)
 {
     if (!data || !count) {
@@ -41,16 +39,11 @@ bool MicSilenceFilterPcmF32::IsSilencePcmData(const char *data, size_t count, fl
 
     // PCM float32 stores values in range [-1.0, 1.0]
 
-    auto samples = reinterpret_cast<const float *>(data);
-    const auto samples_end = samples + (count / sizeof(float)); // each 4 bytes represent a sample
-
-    for (; samples < samples_end; ++samples) {
-        if (std::fabs(*samples) >= sound_threshold) {
-            return false;
-        }
-    }
-
-    return true;
+    return GetMicSilenceKernels().f32(
+        reinterpret_cast<const float *>(data),
+        count / sizeof(float), // each 4 bytes represent a sample
+        sound_threshold
+    );
 }
 
 bool MicSilenceFilterPcmS16::IsSilencePcmData(const char *data, size_t count, float sound_threshold)
@@ -59,19 +52,13 @@ bool MicSilenceFilterPcmS16::IsSilencePcmData(const char *data, size_t count, fl
         return true;
     }
 
-    // PCM signed16 stores values in range [-32768, 32767]
-    const auto threshold = static_cast<int16_t>(32767L * sound_threshold);
-
-    auto samples = reinterpret_cast<const int16_t *>(data);
-    const auto samples_end = samples + (count / sizeof(int16_t));
-
-    for (; samples < samples_end; ++samples) {
-        if (std::abs(*samples) >= threshold) {
-            return false;
-        }
-    }
+    const auto threshold = MicSilenceThresholdS16(sound_threshold);
 
-    return true;
+    return GetMicSilenceKernels().s16(
+        reinterpret_cast<const int16_t *>(data),
+        count / sizeof(int16_t),
+        threshold
+    );
 }
 
 bool MicSilenceFilterPcmS24::IsSilencePcmData(const char *data, size_t count, float sound_threshold)
@@ -85,28 +72,9 @@ bool MicSilenceFilterPcmS24::IsSilencePcmData(const char *data, size_t count, fl
         return false; // invalid data size
     }
 
-    // PCM signed24 stores values in range [-8,388,608, 8,388,607]
-    const int32_t threshold = static_cast<int32_t>(8388607L) * sound_threshold;
-
-    const auto data_end = data + count;
-
-    for (; data < data_end; data += 3) {
-        int32_t sample =
-            static_cast<int32_t>( data[0] ) | 
-            (static_cast<int32_t>( data[1] ) << 8) | 
-            (static_cast<int32_t>( data[2] ) << 16);
-        
-        // sign-extend the 24-bit value to 32 bits
-        if (sample & 0x00800000L) { // notice the digit '8'
-            sample |= 0xFF000000L; // set the upper bits if the sign bit is set
-        }
-
-        if (std::abs(sample) >= threshold) {
-            return false;
-        }
-    }
+    const auto threshold = MicSilenceThresholdS24(sound_threshold);
 
-    return true;
+    return GetMicSilenceKernels().s24(data, count / 3, threshold);
 }
 
 bool MicSilenceFilterPcmS32::IsSilencePcmData(const char *data, size_t count, float sound_threshold)
@@ -115,19 +83,13 @@ bool MicSilenceFilterPcmS32::IsSilencePcmData(const char *data, size_t count, fl
         return true;
     }
 
-    // PCM signed32 stores values in range [-2,147,483,648, 2,147,483,647]
-    const auto threshold = static_cast<int32_t>(2147483647LL * sound_threshold);
-
-    auto samples = reinterpret_cast<const int32_t *>(data);
-    const auto samples_end = samples + (count / sizeof(int32_t));
-
-    for (; samples < samples_end; ++samples) {
-        if (std::abs(*samples) >= threshold) {
-            return false;
-        }
-    }
+    const auto threshold = MicSilenceThresholdS32(sound_threshold);
 
-    return true;
+    return GetMicSilenceKernels().s32(
+        reinterpret_cast<const int32_t *>(data),
+        count / sizeof(int32_t),
+        threshold
+    );
 }
 
 bool MicSilenceFilterPcmU8::IsSilencePcmData(const char *data, size_t count, float sound_threshold)
@@ -136,20 +98,11 @@ bool MicSilenceFilterPcmU8::IsSilencePcmData(const char *data, size_t count, flo
         return true;
     }
 
-    // PCM signed8 stores values in range [-128, 127]
-    // PCM unsigned8 stores values in range [0, 255] (silence midpoint = 128)
-    const auto threshold = static_cast<int8_t>(127L * sound_threshold);
-    constexpr int8_t midpoint = 128;
-
-    auto samples = reinterpret_cast<const uint8_t *>(data);
-    const auto samples_end = samples + (count / sizeof(uint8_t));
-
-    for (; samples < samples_end; ++samples) {
-        const int8_t sample_normalized = static_cast<int8_t>(*samples) - midpoint;
-        if (std::abs(sample_normalized) >= threshold) {
-            return false;
-        }
-    }
+    const auto threshold = MicSilenceThresholdU8(sound_threshold);
 
-    return true;
+    return GetMicSilenceKernels().u8(
+        reinterpret_cast<const uint8_t *>(data),
+        count / sizeof(uint8_t),
+        threshold
+    );
 }
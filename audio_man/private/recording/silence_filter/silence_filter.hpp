@@ -33,6 +33,7 @@ For more information, please refer to <https://unlicense.org>
 class IMicSilenceFilter
 {
 public:
+    // never allocates, safe to call on the audio thread
     virtual bool IsSilencePcmData(const char *data, size_t count, float sound_threshold) = 0;
 };
 
@@ -0,0 +1,417 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#include "silence_filter_kernels.hpp"
+#include "../../cpu_features/cpu_features.hpp"
+#include <algorithm> // std::min
+#include <cmath>
+
+#if defined(AUDIO_MAN_X86)
+    #include <immintrin.h>
+#endif
+
+
+// samples scanned between 2 early exit checks
+static constexpr size_t block_samples = 64;
+
+
+// *** scalar *** //
+// the reference behavior, also used for the remaining samples after the vectorized loops
+
+static bool silence_f32_scalar(const float *samples, size_t count, float threshold)
+{
+    for (size_t idx = 0; idx < count; ++idx) {
+        if (std::fabs(samples[idx]) >= threshold) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool silence_s16_scalar(const int16_t *samples, size_t count, int32_t threshold)
+{
+    for (size_t idx = 0; idx < count; ++idx) {
+        if (std::abs(static_cast<int32_t>(samples[idx])) >= threshold) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool silence_s24_scalar(const char *packed_samples, size_t count, int32_t threshold)
+{
+    auto bytes = reinterpret_cast<const uint8_t *>(packed_samples);
+    for (size_t idx = 0; idx < count; ++idx, bytes += 3) {
+        // place the 24 bits at the top then shift back down, this sign-extends the sample
+        const auto sample = static_cast<int32_t>(
+            (static_cast<uint32_t>(bytes[0]) << 8) |
+            (static_cast<uint32_t>(bytes[1]) << 16) |
+            (static_cast<uint32_t>(bytes[2]) << 24)
+        ) >> 8;
+
+        if (std::abs(sample) >= threshold) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool silence_s32_scalar(const int32_t *samples, size_t count, int32_t threshold)
+{
+    for (size_t idx = 0; idx < count; ++idx) {
+        if (std::abs(static_cast<int64_t>(samples[idx])) >= threshold) { // abs(INT32_MIN) doesn't fit int32
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool silence_u8_scalar(const uint8_t *samples, size_t count, int32_t threshold)
+{
+    for (size_t idx = 0; idx < count; ++idx) {
+        if (std::abs(static_cast<int32_t>(samples[idx]) - 128) >= threshold) {
+            return false;
+        }
+    }
+
+    return true;
+}
+// *** scalar *** //
+
+
+#if defined(AUDIO_MAN_X86)
+
+// the integer kernels track the max and min (or the max magnitude) of a block,
+// then compare against the threshold once per block:
+//   abs(x) >= t  <=>  x > t - 1  ||  x < 1 - t
+// this also works for t == 0 (everything is loud) and for the most negative value
+
+// *** SSE2 *** //
+AUDIO_MAN_TARGET_SSE2
+static bool silence_f32_sse2(const float *samples, size_t count, float threshold)
+{
+    const auto abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const auto thr = _mm_set1_ps(threshold);
+
+    size_t idx = 0;
+    while (idx + block_samples <= count) {
+        auto peak = _mm_setzero_ps();
+        for (const auto block_end = idx + block_samples; idx < block_end; idx += 4) {
+            // 'peak' as the 2nd operand keeps it intact if the sample is NaN, like the scalar compare ignores it
+            peak = _mm_max_ps(_mm_and_ps(_mm_loadu_ps(samples + idx), abs_mask), peak);
+        }
+
+        if (_mm_movemask_ps(_mm_cmpge_ps(peak, thr))) {
+            return false;
+        }
+    }
+
+    return silence_f32_scalar(samples + idx, count - idx, threshold);
+}
+
+AUDIO_MAN_TARGET_SSE2
+static bool silence_s16_sse2(const int16_t *samples, size_t count, int32_t threshold)
+{
+    if (threshold > 32768) { // nothing can reach it
+        return true;
+    }
+
+    const auto thr_hi = _mm_set1_epi16(static_cast<int16_t>(threshold - 1));
+    const auto thr_lo = _mm_set1_epi16(static_cast<int16_t>(1 - threshold));
+
+    size_t idx = 0;
+    while (idx + block_samples <= count) {
+        auto peak_max = _mm_set1_epi16(INT16_MIN);
+        auto peak_min = _mm_set1_epi16(INT16_MAX);
+        for (const auto block_end = idx + block_samples; idx < block_end; idx += 8) {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + idx));
+            peak_max = _mm_max_epi16(peak_max, v);
+            peak_min = _mm_min_epi16(peak_min, v);
+        }
+
+        const auto loud = _mm_or_si128(_mm_cmpgt_epi16(peak_max, thr_hi), _mm_cmplt_epi16(peak_min, thr_lo));
+        if (_mm_movemask_epi8(loud)) {
+            return false;
+        }
+    }
+
+    return silence_s16_scalar(samples + idx, count - idx, threshold);
+}
+
+AUDIO_MAN_TARGET_SSE2
+static bool silence_s32_sse2(const int32_t *samples, size_t count, int32_t threshold)
+{
+    // SSE2 has no 32-bit min/max, accumulate the comparison results instead
+    const auto thr_hi = _mm_set1_epi32(threshold - 1);
+    const auto thr_lo = _mm_set1_epi32(1 - threshold);
+
+    size_t idx = 0;
+    while (idx + block_samples <= count) {
+        auto loud = _mm_setzero_si128();
+        for (const auto block_end = idx + block_samples; idx < block_end; idx += 4) {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + idx));
+            loud = _mm_or_si128(loud, _mm_or_si128(_mm_cmpgt_epi32(v, thr_hi), _mm_cmplt_epi32(v, thr_lo)));
+        }
+
+        if (_mm_movemask_epi8(loud)) {
+            return false;
+        }
+    }
+
+    return silence_s32_scalar(samples + idx, count - idx, threshold);
+}
+
+AUDIO_MAN_TARGET_SSE2
+static bool silence_u8_sse2(const uint8_t *samples, size_t count, int32_t threshold)
+{
+    if (threshold > 128) { // nothing can reach it
+        return true;
+    }
+
+    const auto midpoint = _mm_set1_epi8(static_cast<char>(128));
+    const auto thr = _mm_set1_epi8(static_cast<char>(threshold));
+
+    size_t idx = 0;
+    while (idx + block_samples <= count) {
+        auto peak = _mm_setzero_si128();
+        for (const auto block_end = idx + block_samples; idx < block_end; idx += 16) {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + idx));
+            // |v - 128| without leaving 8 bits, one of the saturating subtractions is always 0
+            const auto magnitude = _mm_or_si128(_mm_subs_epu8(v, midpoint), _mm_subs_epu8(midpoint, v));
+            peak = _mm_max_epu8(peak, magnitude);
+        }
+
+        // unsigned peak >= thr
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(peak, thr), peak))) {
+            return false;
+        }
+    }
+
+    return silence_u8_scalar(samples + idx, count - idx, threshold);
+}
+// *** SSE2 *** //
+
+
+// *** SSSE3 *** //
+AUDIO_MAN_TARGET_SSSE3
+static bool silence_s24_ssse3(const char *packed_samples, size_t count, int32_t threshold)
+{
+    // 4 packed samples (12 bytes) into the upper 3 bytes of 4 int32 lanes, the lowest byte is zeroed (-1)
+    const auto unpack = _mm_setr_epi8(
+        -1, 0, 1, 2,
+        -1, 3, 4, 5,
+        -1, 6, 7, 8,
+        -1, 9, 10, 11
+    );
+    const auto thr_hi = _mm_set1_epi32(threshold - 1);
+    const auto thr_lo = _mm_set1_epi32(1 - threshold);
+
+    size_t idx = 0;
+    // every load reads 16 bytes but consumes 12, stop while the next load still fits
+    while ((idx + block_samples) * 3 + 4 <= count * 3) {
+        auto loud = _mm_setzero_si128();
+        for (const auto block_end = idx + block_samples; idx < block_end; idx += 4) {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(packed_samples + idx * 3));
+            v = _mm_srai_epi32(_mm_shuffle_epi8(v, unpack), 8); // sign-extend
+            loud = _mm_or_si128(loud, _mm_or_si128(_mm_cmpgt_epi32(v, thr_hi), _mm_cmplt_epi32(v, thr_lo)));
+        }
+
+        if (_mm_movemask_epi8(loud)) {
+            return false;
+        }
+    }
+
+    return silence_s24_scalar(packed_samples + idx * 3, count - idx, threshold);
+}
+// *** SSSE3 *** //
+
+
+// *** AVX2 *** //
+AUDIO_MAN_TARGET_AVX2
+static bool silence_f32_avx2(const float *samples, size_t count, float threshold)
+{
+    const auto abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const auto thr = _mm256_set1_ps(threshold);
+
+    size_t idx = 0;
+    while (idx + block_samples <= count) {
+        auto peak = _mm256_setzero_ps();
+        for (const auto block_end = idx + block_samples; idx < block_end; idx += 8) {
+            peak = _mm256_max_ps(_mm256_and_ps(_mm256_loadu_ps(samples + idx), abs_mask), peak);
+        }
+
+        if (_mm256_movemask_ps(_mm256_cmp_ps(peak, thr, _CMP_GE_OQ))) {
+            return false;
+        }
+    }
+
+    return silence_f32_scalar(samples + idx, count - idx, threshold);
+}
+
+AUDIO_MAN_TARGET_AVX2
+static bool silence_s16_avx2(const int16_t *samples, size_t count, int32_t threshold)
+{
+    if (threshold > 32768) { // nothing can reach it
+        return true;
+    }
+
+    const auto thr_hi = _mm256_set1_epi16(static_cast<int16_t>(threshold - 1));
+    const auto thr_lo = _mm256_set1_epi16(static_cast<int16_t>(1 - threshold));
+
+    size_t idx = 0;
+    while (idx + block_samples <= count) {
+        auto peak_max = _mm256_set1_epi16(INT16_MIN);
+        auto peak_min = _mm256_set1_epi16(INT16_MAX);
+        for (const auto block_end = idx + block_samples; idx < block_end; idx += 16) {
+            const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + idx));
+            peak_max = _mm256_max_epi16(peak_max, v);
+            peak_min = _mm256_min_epi16(peak_min, v);
+        }
+
+        const auto loud = _mm256_or_si256(_mm256_cmpgt_epi16(peak_max, thr_hi), _mm256_cmpgt_epi16(thr_lo, peak_min));
+        if (_mm256_movemask_epi8(loud)) {
+            return false;
+        }
+    }
+
+    return silence_s16_scalar(samples + idx, count - idx, threshold);
+}
+
+AUDIO_MAN_TARGET_AVX2
+static bool silence_s32_avx2(const int32_t *samples, size_t count, int32_t threshold)
+{
+    const auto thr_hi = _mm256_set1_epi32(threshold - 1);
+    const auto thr_lo = _mm256_set1_epi32(1 - threshold);
+
+    size_t idx = 0;
+    while (idx + block_samples <= count) {
+        auto peak_max = _mm256_set1_epi32(INT32_MIN);
+        auto peak_min = _mm256_set1_epi32(INT32_MAX);
+        for (const auto block_end = idx + block_samples; idx < block_end; idx += 8) {
+            const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + idx));
+            peak_max = _mm256_max_epi32(peak_max, v);
+            peak_min = _mm256_min_epi32(peak_min, v);
+        }
+
+        const auto loud = _mm256_or_si256(_mm256_cmpgt_epi32(peak_max, thr_hi), _mm256_cmpgt_epi32(thr_lo, peak_min));
+        if (_mm256_movemask_epi8(loud)) {
+            return false;
+        }
+    }
+
+    return silence_s32_scalar(samples + idx, count - idx, threshold);
+}
+
+AUDIO_MAN_TARGET_AVX2
+static bool silence_u8_avx2(const uint8_t *samples, size_t count, int32_t threshold)
+{
+    if (threshold > 128) { // nothing can reach it
+        return true;
+    }
+
+    const auto midpoint = _mm256_set1_epi8(static_cast<char>(128));
+    const auto thr = _mm256_set1_epi8(static_cast<char>(threshold));
+
+    size_t idx = 0;
+    while (idx + block_samples <= count) {
+        auto peak = _mm256_setzero_si256();
+        for (const auto block_end = idx + block_samples; idx < block_end; idx += 32) {
+            const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + idx));
+            const auto magnitude = _mm256_or_si256(_mm256_subs_epu8(v, midpoint), _mm256_subs_epu8(midpoint, v));
+            peak = _mm256_max_epu8(peak, magnitude);
+        }
+
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(peak, thr), peak))) {
+            return false;
+        }
+    }
+
+    return silence_u8_scalar(samples + idx, count - idx, threshold);
+}
+// *** AVX2 *** //
+
+#endif // AUDIO_MAN_X86
+
+
+static MicSilenceKernels_t select_kernels()
+{
+    MicSilenceKernels_t kernels{ silence_f32_scalar, silence_s16_scalar, silence_s24_scalar, silence_s32_scalar, silence_u8_scalar };
+
+#if defined(AUDIO_MAN_X86)
+    const auto &features = GetCpuFeatures();
+    if (features.avx2) {
+        kernels = { silence_f32_avx2, silence_s16_avx2, silence_s24_ssse3, silence_s32_avx2, silence_u8_avx2 };
+    } else if (features.sse2) {
+        kernels = { silence_f32_sse2, silence_s16_sse2, silence_s24_scalar, silence_s32_sse2, silence_u8_sse2 };
+        if (features.ssse3) {
+            kernels.s24 = silence_s24_ssse3;
+        }
+    }
+#endif
+
+    return kernels;
+}
+
+const MicSilenceKernels_t& GetMicSilenceKernels()
+{
+    static const MicSilenceKernels_t kernels = select_kernels();
+    return kernels;
+}
+
+
+// https://en.wikipedia.org/wiki/Audio_bit_depth
+
+int32_t MicSilenceThresholdS16(float sound_threshold)
+{
+    // PCM signed16 stores values in range [-32768, 32767]
+    return static_cast<int16_t>(32767L * sound_threshold);
+}
+
+int32_t MicSilenceThresholdS24(float sound_threshold)
+{
+    // PCM signed24 stores values in range [-8,388,608, 8,388,607]
+    return static_cast<int32_t>(static_cast<int32_t>(8388607L) * sound_threshold);
+}
+
+int32_t MicSilenceThresholdS32(float sound_threshold)
+{
+    // PCM signed32 stores values in range [-2,147,483,648, 2,147,483,647]
+    // a threshold of 100% rounds to 2^31 in float which doesn't fit int32, compute in double and clamp
+    return static_cast<int32_t>(std::min(2147483647.0 * sound_threshold, 2147483647.0));
+}
+
+int32_t MicSilenceThresholdU8(float sound_threshold)
+{
+    // PCM signed8 stores values in range [-128, 127]
+    // PCM unsigned8 stores values in range [0, 255] (silence midpoint = 128)
+    return static_cast<int8_t>(127L * sound_threshold);
+}
@@ -0,0 +1,52 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#pragma once
+
+#include <cstring> // size_t
+#include <cstdint> // intxx_t
+
+
+// bulk silence detection kernels, each returns true if the magnitude of every sample is below the threshold
+// the samples are scanned in blocks and the scan stops at the first block which has a loud sample
+struct MicSilenceKernels_t {
+    bool (*f32)(const float *samples, size_t count, float threshold); // magnitude in [0.0, 1.0]
+    bool (*s16)(const int16_t *samples, size_t count, int32_t threshold);
+    bool (*s24)(const char *packed_samples, size_t count, int32_t threshold); // 'count' samples of 3 bytes each
+    bool (*s32)(const int32_t *samples, size_t count, int32_t threshold);
+    bool (*u8)(const uint8_t *samples, size_t count, int32_t threshold); // magnitude is the distance from 128
+};
+
+// the fastest kernels supported by this cpu, selected once on first use
+const MicSilenceKernels_t& GetMicSilenceKernels();
+
+// kernel thresholds from a threshold in [0.0, 1.0] of the format's full scale
+int32_t MicSilenceThresholdS16(float sound_threshold);
+int32_t MicSilenceThresholdS24(float sound_threshold);
+int32_t MicSilenceThresholdS32(float sound_threshold);
+int32_t MicSilenceThresholdU8(float sound_threshold);
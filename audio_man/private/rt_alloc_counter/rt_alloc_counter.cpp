@@ -0,0 +1,132 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+#if defined(AUDIO_MAN_COUNT_RT_ALLOCATIONS)
+    #include <new>
+    #include <cstdlib> // std::malloc
+    #include <cstddef> // std::max_align_t
+#endif
+
+#include "rt_alloc_counter.hpp"
+
+
+
+// constant initialized, so it's safe to touch from operator new at any time
+static thread_local std::atomic<size_t> *realtime_counter = nullptr;
+
+RealtimeAllocScope::RealtimeAllocScope(std::atomic<size_t> &counter)
+{
+    previous_counter = realtime_counter;
+    realtime_counter = &counter;
+}
+
+RealtimeAllocScope::~RealtimeAllocScope()
+{
+    realtime_counter = previous_counter;
+}
+
+void CountRealtimeAllocation()
+{
+#if !defined(AUDIO_MAN_COUNT_RT_ALLOCATIONS)
+    if (realtime_counter) {
+        realtime_counter->fetch_add(1, std::memory_order_relaxed);
+    }
+#endif
+}
+
+
+
+#if defined(AUDIO_MAN_COUNT_RT_ALLOCATIONS)
+// *** global operator new/delete *** //
+static void* counted_alloc(std::size_t size, std::size_t alignment) noexcept
+{
+    if (realtime_counter) {
+        realtime_counter->fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (!size) {
+        size = 1;
+    }
+
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size);
+    }
+
+#if defined(_WIN32)
+    return _aligned_malloc(size, alignment);
+#else
+    void *ptr = nullptr;
+    return posix_memalign(&ptr, alignment, size) == 0 ? ptr : nullptr;
+#endif
+}
+
+static void counted_free(void *ptr, std::size_t alignment) noexcept
+{
+#if defined(_WIN32)
+    if (alignment > alignof(std::max_align_t)) {
+        _aligned_free(ptr);
+        return;
+    }
+#else
+    (void)alignment;
+#endif
+    std::free(ptr);
+}
+
+static void* counted_alloc_or_throw(std::size_t size, std::size_t alignment)
+{
+    auto ptr = counted_alloc(size, alignment);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new(std::size_t size) { return counted_alloc_or_throw(size, 0); }
+void* operator new[](std::size_t size) { return counted_alloc_or_throw(size, 0); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return counted_alloc_or_throw(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return counted_alloc_or_throw(size, static_cast<std::size_t>(alignment)); }
+void* operator new(std::size_t size, const std::nothrow_t &) noexcept { return counted_alloc(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t &) noexcept { return counted_alloc(size, 0); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept { return counted_alloc(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept { return counted_alloc(size, static_cast<std::size_t>(alignment)); }
+
+void operator delete(void *ptr) noexcept { counted_free(ptr, 0); }
+void operator delete[](void *ptr) noexcept { counted_free(ptr, 0); }
+void operator delete(void *ptr, std::size_t) noexcept { counted_free(ptr, 0); }
+void operator delete[](void *ptr, std::size_t) noexcept { counted_free(ptr, 0); }
+void operator delete(void *ptr, std::align_val_t alignment) noexcept { counted_free(ptr, static_cast<std::size_t>(alignment)); }
+void operator delete[](void *ptr, std::align_val_t alignment) noexcept { counted_free(ptr, static_cast<std::size_t>(alignment)); }
+void operator delete(void *ptr, std::size_t, std::align_val_t alignment) noexcept { counted_free(ptr, static_cast<std::size_t>(alignment)); }
+void operator delete[](void *ptr, std::size_t, std::align_val_t alignment) noexcept { counted_free(ptr, static_cast<std::size_t>(alignment)); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { counted_free(ptr, 0); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { counted_free(ptr, 0); }
+void operator delete(void *ptr, std::align_val_t alignment, const std::nothrow_t &) noexcept { counted_free(ptr, static_cast<std::size_t>(alignment)); }
+void operator delete[](void *ptr, std::align_val_t alignment, const std::nothrow_t &) noexcept { counted_free(ptr, static_cast<std::size_t>(alignment)); }
+// *** global operator new/delete *** //
+#endif
@@ -0,0 +1,162 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <bit> // std::bit_ceil
+#include <algorithm> // std::min, std::copy_n
+#include <cstring> // size_t
+
+
+// bounded wait-free queue for exactly 1 producer thread and 1 consumer thread
+// slots are constructed once in Reset() and reused afterwards, the producer fills a slot in place
+// so pushing never allocates as long as T itself doesn't allocate when assigned
+template<typename T>
+class SpscRing
+{
+private:
+    // avoid false sharing between the producer and the consumer indices
+    static constexpr size_t cache_line = 64;
+
+    std::vector<T> slots{};
+    size_t mask{};
+
+    alignas(cache_line) std::atomic<size_t> head{}; // next slot to read, written by the consumer only
+    alignas(cache_line) std::atomic<size_t> tail{}; // next slot to write, written by the producer only
+
+public:
+    // not thread safe, must be called while no producer/consumer is active
+    // capacity is rounded up to the next power of 2
+    void Reset(size_t capacity)
+    {
+        if (capacity < 2) {
+            capacity = 2;
+        }
+        capacity = std::bit_ceil(capacity);
+
+        slots.clear();
+        slots.resize(capacity);
+        mask = capacity - 1;
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+    // not thread safe, must be called while no producer/consumer is active
+    // useful to preallocate whatever the slots hold
+    template<typename Fn>
+    void ForEachSlot(Fn fn)
+    {
+        for (auto &slot : slots) {
+            fn(slot);
+        }
+    }
+
+    size_t Capacity() const
+    {
+        return slots.size();
+    }
+
+    // approximate when called while the other side is active
+    size_t Size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    bool Empty() const
+    {
+        return Size() == 0;
+    }
+
+    // *** producer side *** //
+    // returns the next free slot to be filled, or nullptr if the ring is full (or was never Reset())
+    T* BeginPush()
+    {
+        const auto cur_tail = tail.load(std::memory_order_relaxed);
+        if (cur_tail - head.load(std::memory_order_acquire) >= slots.size()) {
+            return nullptr;
+        }
+
+        return &slots[cur_tail & mask];
+    }
+
+    // publish the slot returned by BeginPush()
+    void CommitPush()
+    {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // copies as many of 'items' as there are free slots and publishes them at once, returns how many were pushed
+    size_t PushBulk(const T *items, size_t count)
+    {
+        const auto cur_tail = tail.load(std::memory_order_relaxed);
+        count = std::min(count, slots.size() - (cur_tail - head.load(std::memory_order_acquire)));
+
+        const auto first_count = std::min(count, slots.size() - (cur_tail & mask));
+        std::copy_n(items, first_count, slots.begin() + (cur_tail & mask));
+        std::copy_n(items + first_count, count - first_count, slots.begin());
+
+        tail.store(cur_tail + count, std::memory_order_release);
+        return count;
+    }
+    // *** producer side *** //
+
+    // *** consumer side *** //
+    // returns the oldest published slot, or nullptr if the ring is empty
+    T* Front()
+    {
+        const auto cur_head = head.load(std::memory_order_relaxed);
+        if (cur_head == tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+
+        return &slots[cur_head & mask];
+    }
+
+    // release the slot returned by Front() back to the producer
+    void Pop()
+    {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // copies up to 'count' of the oldest published slots to 'out' and releases them at once, returns how many were popped
+    size_t PopBulk(T *out, size_t count)
+    {
+        const auto cur_head = head.load(std::memory_order_relaxed);
+        count = std::min(count, tail.load(std::memory_order_acquire) - cur_head);
+
+        const auto first_count = std::min(count, slots.size() - (cur_head & mask));
+        std::copy_n(slots.begin() + (cur_head & mask), first_count, out);
+        std::copy_n(slots.begin(), count - first_count, out + first_count);
+
+        head.store(cur_head + count, std::memory_order_release);
+        return count;
+    }
+    // *** consumer side *** //
+
+};
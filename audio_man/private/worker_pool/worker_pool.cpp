@@ -0,0 +1,117 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+
+#include <system_error>
+#include <algorithm>
+
+#include "worker_pool.hpp"
+
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard lock(mtx);
+        stop_requested = true;
+    }
+    work_cv.notify_all();
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::worker_loop(uint64_t seen_generation)
+{
+    std::unique_lock lock(mtx);
+    for (;;) {
+        work_cv.wait(lock, [this, seen_generation]{
+            return stop_requested || (generation != seen_generation && helpers_joined < helpers_wanted);
+        });
+        if (stop_requested) {
+            return;
+        }
+
+        seen_generation = generation;
+        ++helpers_joined;
+        ++helpers_running;
+        const auto fn = task;
+
+        lock.unlock();
+        (*fn)();
+        lock.lock();
+
+        if (!--helpers_running) {
+            done_cv.notify_one();
+        }
+    }
+}
+
+void WorkerPool::wait_helpers()
+{
+    std::unique_lock lock(mtx);
+    helpers_wanted = helpers_joined; // whoever didn't wake up yet isn't needed anymore
+    done_cv.wait(lock, [this]{ return !helpers_running; });
+    task = nullptr;
+}
+
+void WorkerPool::Run(const std::function<void()> &fn, unsigned int helpers)
+{
+    std::unique_lock run_lock(run_mtx, std::try_to_lock);
+    if (!run_lock.owns_lock() || !helpers) {
+        fn();
+        return;
+    }
+
+    {
+        std::lock_guard lock(mtx);
+
+        // a thread which can't be created (limits, resources) just means fewer helpers
+        while (threads.size() < helpers) {
+            try {
+                threads.emplace_back([this, seen_generation = generation]{ worker_loop(seen_generation); });
+            } catch (const std::system_error &) {
+                break;
+            }
+        }
+
+        task = &fn;
+        ++generation;
+        helpers_wanted = std::min(helpers, static_cast<unsigned int>(threads.size()));
+        helpers_joined = 0;
+    }
+    work_cv.notify_all();
+
+    try {
+        fn();
+    } catch (...) {
+        wait_helpers(); // 'fn' must outlive the helpers
+        throw;
+    }
+    wait_helpers();
+}
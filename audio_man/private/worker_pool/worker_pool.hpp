@@ -0,0 +1,74 @@
+/*
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <https://unlicense.org>
+*/
+
+
+
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <cstdint> // uintxx_t
+
+
+// helper threads kept alive between calls, created on first use and grown up to what a call asks for
+// Run() calls 'fn' on up to 'helpers' pool threads and on the calling thread, 'fn' should pull its work from a shared queue
+// so that however many helpers actually join, the calling thread alone is enough to finish it
+class WorkerPool
+{
+private:
+    std::mutex mtx{};
+    std::condition_variable work_cv{};
+    std::condition_variable done_cv{};
+    std::vector<std::thread> threads{};
+    bool stop_requested{};
+
+    // current task, all guarded by 'mtx'
+    const std::function<void()> *task{};
+    uint64_t generation{}; // bumped for every Run(), a helper joins a task once
+    unsigned int helpers_wanted{};
+    unsigned int helpers_joined{};
+    unsigned int helpers_running{};
+
+    std::mutex run_mtx{}; // one task at a time
+
+    void worker_loop(uint64_t seen_generation);
+    void wait_helpers();
+
+public:
+    WorkerPool() = default;
+    WorkerPool(const WorkerPool &other) = delete;
+    ~WorkerPool();
+
+    WorkerPool& operator=(const WorkerPool &other) = delete;
+
+    // returns once 'fn' returned everywhere it was called
+    // while another Run() is in progress 'fn' is only called on the calling thread
+    void Run(const std::function<void()> &fn, unsigned int helpers);
+};
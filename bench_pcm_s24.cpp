@@ -0,0 +1,118 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <cstdint> // uintxx_t
+#include <cstring> // std::memcpy
+
+
+#include "audio_man/private/recording/mic_gain/mic_gain.hpp"
+#include "audio_man/private/recording/silence_filter/silence_filter.hpp"
+
+
+// the 24-bit implementation before the packed kernels, kept here as the baseline
+// both write into the same preallocated output so only the kernels are compared
+namespace legacy {
+
+void ApplyGain(const char *data, size_t count, float sound_gain, char *out)
+{
+  const auto data_end = data + count;
+
+  for (; data < data_end; data += 3, out += 3) {
+    int32_t sample =
+      static_cast<int32_t>( data[0] ) |
+      (static_cast<int32_t>( data[1] ) << 8) |
+      (static_cast<int32_t>( data[2] ) << 16);
+
+    if (sample & 0x00800000L) {
+      sample |= 0xFF000000L;
+    }
+
+    sample = static_cast<int32_t>(
+      std::min(std::max(sample * static_cast<double>(sound_gain), -8388608.0), 8388607.0)
+    );
+    auto sample_buff = reinterpret_cast<char *>(&sample);
+
+    out[0] = sample_buff[0];
+    out[1] = sample_buff[1];
+    out[2] = sample_buff[2];
+  }
+}
+
+bool IsSilencePcmData(const char *data, size_t count, float sound_threshold)
+{
+  const int32_t threshold = static_cast<int32_t>(8388607L) * sound_threshold;
+
+  const auto data_end = data + count;
+
+  for (; data < data_end; data += 3) {
+    int32_t sample =
+      static_cast<int32_t>( data[0] ) |
+      (static_cast<int32_t>( data[1] ) << 8) |
+      (static_cast<int32_t>( data[2] ) << 16);
+
+    if (sample & 0x00800000L) {
+      sample |= 0xFF000000L;
+    }
+
+    if (std::abs(sample) >= threshold) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}
+
+
+// returns the throughput in MB/s
+double measure(size_t bytes_per_call, size_t calls, const std::function<void()> &fn)
+{
+  fn(); // warm up
+
+  auto t1 = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < calls; ++i) {
+    fn();
+  }
+  auto t2 = std::chrono::high_resolution_clock::now();
+
+  auto secs = std::chrono::duration<double>(t2 - t1).count();
+  return (bytes_per_call * calls) / secs / (1024.0 * 1024.0);
+}
+
+int main()
+{
+  // 16 channels at 96 kHz, 10 ms periods
+  constexpr size_t frames = 960;
+  constexpr size_t channels = 16;
+  constexpr size_t samples = frames * channels;
+  constexpr size_t bytes = samples * 3;
+  constexpr size_t calls = 2000;
+
+  // quiet signal, so the silence detection has to scan the whole period
+  std::vector<char> period(bytes);
+  std::mt19937 rng(1234);
+  for (size_t i = 0; i < samples; ++i) {
+    int32_t sample = static_cast<int32_t>(rng() % 2001) - 1000;
+    std::memcpy(&period[i * 3], &sample, 3);
+  }
+
+  std::vector<char> out(bytes);
+  MicGainPcmS24 gain{};
+  MicSilenceFilterPcmS24 silence{};
+  volatile bool sink = false;
+
+  auto legacy_gain = measure(bytes, calls, [&]{ legacy::ApplyGain(period.data(), bytes, 6.55f, out.data()); });
+  auto new_gain = measure(bytes, calls, [&]{ gain.ApplyGain(period.data(), bytes, 6.55f, out.data()); });
+  auto legacy_silence = measure(bytes, calls, [&]{ sink = legacy::IsSilencePcmData(period.data(), bytes, 0.5f); });
+  auto new_silence = measure(bytes, calls, [&]{ sink = silence.IsSilencePcmData(period.data(), bytes, 0.5f); });
+
+  std::cout << "s24 " << channels << "ch x " << frames << " frames per period, " << calls << " periods" << std::endl;
+  std::cout << "gain    legacy=" << legacy_gain << " MB/s  new=" << new_gain << " MB/s  x" << new_gain / legacy_gain << std::endl;
+  std::cout << "silence legacy=" << legacy_silence << " MB/s  new=" << new_silence << " MB/s  x" << new_silence / legacy_silence << std::endl;
+
+  return 0;
+}
@@ -13,59 +13,50 @@
 #include <functional>
 #include <iterator>
 #include <future>
+#include <memory>
 #include <cstdint> // uintxx_t
-#include <cstring> // std::memcpy
 
 
 #include "audio_man/audio_man.hpp"
 
 
-// WAV header
-#pragma pack(push, 1)
-struct WavHeader_t
+// an archive whose footer points the index outside the file must be rejected, not read
+static bool check_crafted_archive_footer()
 {
-    char riff[4] = {'R', 'I', 'F', 'F'};
-    uint32_t chunkSize;             // Total size minus 8 bytes (above 4 bytes + this field)
-    char wave[4] = {'W', 'A', 'V', 'E'};
-    char fmt[4] = {'f', 'm', 't', ' '};
-    uint32_t fmtChunkSize = 16;     // PCM header size
-    uint16_t audioFormat = 1;       // PCM = 1
-    uint16_t numChannels;           // 1 = Mono, 2 = Stereo
-    uint32_t sampleRate;            // e.g., 44100
-    uint32_t byteRate;              // = sampleRate * numChannels * bytesPerSample
-    uint16_t blockAlign;            // = numChannels * bytesPerSample
-    uint16_t bitsPerSample;         // e.g., 16
-    char data[4] = {'d', 'a', 't', 'a'};
-    uint32_t dataSize;              // Number of bytes in data section
-};
-#pragma pack(pop)
-
-std::vector<char> pcm_to_wav(const std::vector<char> &pcm_data, uint32_t sample_rate, uint16_t channels_count, uint16_t bits_per_sample)
-{
-  uint32_t dataSize = static_cast<uint32_t>(pcm_data.size());
-  uint32_t chunkSize = 36 + dataSize;
-
-  WavHeader_t header{};
-  header.chunkSize = chunkSize;
-  header.numChannels = channels_count;
-  header.sampleRate = sample_rate;
-  header.bitsPerSample = bits_per_sample;
-  header.byteRate = sample_rate * channels_count * (bits_per_sample / 8);
-  header.blockAlign = channels_count * (bits_per_sample / 8);
-  header.dataSize = dataSize;
-
-  // concat header and pcm data
-  std::vector<char> wavData(sizeof(WavHeader_t) + dataSize);
-  std::memcpy(wavData.data(), &header, sizeof(WavHeader_t));
-  std::memcpy(wavData.data() + sizeof(WavHeader_t), pcm_data.data(), dataSize);
-
-  return wavData;
-}
+  const auto path = (std::filesystem::temp_directory_path() / "audio_man_crafted.amar").string();
+  {
+    auto writer = RecordingArchiveWriter();
+    if (!writer.Open(path.c_str()) || !writer.Close()) {
+      return false;
+    }
+  }
 
+  // the footer starts with 'index_offset' then 'entries_count', 24 bytes in total
+  const auto footer_pos = static_cast<std::streamoff>(std::filesystem::file_size(path) - 24);
+  for (const uint64_t index_offset : { UINT64_MAX - 15, UINT64_MAX / 2, uint64_t{8} }) {
+    const uint64_t entries_count = index_offset == 8 ? UINT64_MAX / 16 : 1;
+    auto file = std::fstream(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(footer_pos);
+    file.write(reinterpret_cast<const char*>(&index_offset), sizeof(index_offset));
+    file.write(reinterpret_cast<const char*>(&entries_count), sizeof(entries_count));
+    file.close();
+
+    // falls back to scanning, which finds no chunks
+    auto reader = RecordingArchiveReader();
+    if (reader.Open(path.c_str()) && reader.GetEndFrame() != reader.GetBeginFrame()) {
+      return false;
+    }
+  }
+
+  std::filesystem::remove(path);
+  return true;
+}
 
 
 int main(int argc, char** argv)
 {
+  std::cout << "crafted archive footer rejected=" << check_crafted_archive_footer() << std::endl;
+
   auto amn = AudioMan();
   if (!amn.InitPlayback()) {
     std::cerr << "failed to init playback device\n";
@@ -78,14 +69,15 @@ int main(int argc, char** argv)
       amn.SetRecordingSoundGainPercent(655.0f);
       amn.SetRecordingSoundThresholdPercent(10.5);
       std::cout << "started mic loopback!" << std::endl;
+      auto loopback = amn.OpenPlaybackStream(RecordingFormat_t::Signed16, 2, 48000);
 
       auto tt1 = std::chrono::high_resolution_clock::now();
       while (amn.IsRecording()) {
-        auto chunks_size = amn.SizeUnreadRecording();
-        if (!chunks_size) {
+        if (!amn.WaitForRecording(1, std::chrono::milliseconds(100))) {
           // std::cout << "silence! (no data)" << std::endl;
           continue;
         }
+        auto chunks_size = amn.SizeUnreadRecording();
 
 auto t1 = std::chrono::high_resolution_clock::now();
         auto chunks = amn.GetUnreadRecording(chunks_size);
@@ -95,8 +87,7 @@ auto t1 = std::chrono::high_resolution_clock::now();
         }
 
         auto deco = amn.DecodeRecordingChunks(chunks);
-        auto wav = pcm_to_wav(deco, 48000, 2, 16);
-        amn.SubmitAudio(wav);
+        loopback.Write(deco);
 auto t2 = std::chrono::high_resolution_clock::now();
         std::cout << "## data ##" << std::endl;
 auto dd = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
@@ -112,6 +103,8 @@ std::cout << "total processing time (us) " << dd << std::endl;
       
       amn.StopRecording();
       std::cout << "stopped mic loopback!" << std::endl;
+      std::cout << "loopback underruns=" << loopback.GetUnderrunsCount() << std::endl;
+      std::cout << "audio thread allocations=" << amn.GetRecordingRealtimeAllocationsCount() << std::endl;
     }
   }
 
@@ -124,9 +117,7 @@ std::cout << "total processing time (us) " << dd << std::endl;
 
       auto chunks = amn.GetUnreadRecording();
       auto deco = amn.DecodeRecordingChunks(chunks);
-      auto dd = pcm_to_wav(deco, 44100, 1, 16);
-
-      auto resrec = amn.SubmitAudio(dd);
+      auto resrec = amn.SubmitPcm(deco.data(), deco.size() / 2, RecordingFormat_t::Signed16, 1, 44100);
       std::cout << "recording playback=" << resrec.Wait() << std::endl;
     }
   }
@@ -145,9 +136,11 @@ std::cout << "total processing time (us) " << dd << std::endl;
   fdata.read(&data[0], data.size());
   fdata.close();
 
-  auto res = amn.SubmitAudio(data);
-  std::this_thread::sleep_for(std::chrono::milliseconds(20));
-  auto res2 = amn.SubmitAudio(data);
+  // both requests play the same buffer
+  auto shared_data = std::make_shared<const std::vector<char>>(std::move(data));
+  auto res2 = amn.PrepareAudio(shared_data);
+  auto res = amn.SubmitAudio(shared_data);
+  res2.Start(amn.GetPlaybackTimeFrames() + amn.GetPlaybackSampleRate() / 50); // 20 ms later
 
   std::this_thread::sleep_for(std::chrono::milliseconds(50));
   amn.CancelAllPlayback();